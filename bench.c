@@ -0,0 +1,701 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "scheduler.h"
+
+// Burst distributions of the synthetic workloads
+#define NUM_DISTRIBUTIONS 3
+// Arrival patterns of the perf gate's corpus: Poisson arrivals, then all at time 0
+#define NUM_ARRIVALS 2
+// Processes of each workload of the perf gate's corpus, small enough for the tick engine's scans
+#define CHECK_PROCESSES 2000
+// Longest line of a baseline file
+#define BASELINE_LINE_SIZE 256
+
+// One simulator configuration timed by the benchmark
+typedef struct {
+    const char* name;       // Name printed in the results
+    Policy policy;          // Scheduling policy
+    int quantum;            // Time quantum for Round Robin, 0 otherwise
+    Engine engine;          // Simulation engine
+    Accounting accounting;  // How wait and turnaround times are maintained
+    Layout layout;          // Layout swept by scan accounting
+    int num_cores;          // Number of cores
+    int num_threads;        // Threads of the analytic engine, 0 for one per online CPU
+} Variant;
+
+// First process whose results differ from those of the tick scan reference
+typedef struct {
+    int id;                         // Process ID
+    int64_t wait_time;              // Wait time of the variant
+    int64_t turnaround_time;        // Turnaround time of the variant
+    int64_t reference_wait_time;    // Wait time of the reference
+    int64_t reference_turnaround_time; // Turnaround time of the reference
+} Mismatch;
+
+// Result of timing one variant, handed back by the child process that ran it
+typedef struct {
+    bool ok;                // Whether the variant could be run
+    int runs;               // Repetitions timed
+    double seconds;         // Mean time of one repetition
+    int64_t events;         // Events of one repetition, 0 if the variant does not count them
+    long peak_rss;          // Peak resident set size of the child, in kilobytes
+    uint64_t digest;        // Hash of the per-process wait and turnaround times
+    int mismatches;         // Processes whose times differ from the tick scan reference, -1 if it was not run
+    Mismatch first_mismatch; // First of them
+} Measurement;
+
+// Benchmark configuration from the command line
+typedef struct {
+    int max_processes;      // Largest workload
+    int max_tick_processes; // Largest workload given to the tick engine
+    uint64_t seed;          // Seed of the workload generator
+    double min_time;        // Seconds each variant is repeated for at least
+    bool compare;           // Whether each run is checked against the tick scan reference
+} BenchConfig;
+
+// Measurement of one variant on one workload of the corpus stored by a baseline
+typedef struct {
+    char workload[32];      // Burst distribution and arrival pattern
+    char variant[32];       // Name of the variant
+    double events_per_second; // Throughput
+    uint64_t digest;        // Hash of the per-process wait and turnaround times
+} BaselineEntry;
+
+// Baseline of the perf gate, loaded from and recorded to a file
+typedef struct {
+    BaselineEntry* entries; // Measurements
+    int count;              // Measurements held
+    int capacity;           // Measurements entries can hold without growing
+} Baseline;
+
+// Timed variants; every policy runs on the event engine before the tick and
+// analytic engines, which count no segments and reuse the count of the event run
+static const Variant variants[] = {
+    { "fcfs event",        POLICY_FCFS, 0, ENGINE_EVENT, ACCOUNTING_INCREMENTAL, LAYOUT_AOS, 1, 1 },
+    { "sjf event",         POLICY_SJF,  0, ENGINE_EVENT, ACCOUNTING_INCREMENTAL, LAYOUT_AOS, 1, 1 },
+    { "rr4 event",         POLICY_RR,   4, ENGINE_EVENT, ACCOUNTING_INCREMENTAL, LAYOUT_AOS, 1, 1 },
+    { "mlfq event",        POLICY_MLFQ, 0, ENGINE_EVENT, ACCOUNTING_INCREMENTAL, LAYOUT_AOS, 1, 1 },
+    { "cfs event",         POLICY_CFS,  0, ENGINE_EVENT, ACCOUNTING_INCREMENTAL, LAYOUT_AOS, 1, 1 },
+    { "rr4 event 4 cores", POLICY_RR,   4, ENGINE_EVENT, ACCOUNTING_INCREMENTAL, LAYOUT_AOS, 4, 1 },
+    { "fcfs analytic",     POLICY_FCFS, 0, ENGINE_ANALYTIC, ACCOUNTING_INCREMENTAL, LAYOUT_AOS, 1, 1 },
+    { "fcfs analytic mt",  POLICY_FCFS, 0, ENGINE_ANALYTIC, ACCOUNTING_INCREMENTAL, LAYOUT_AOS, 1, 0 },
+    { "fcfs tick",         POLICY_FCFS, 0, ENGINE_TICK,  ACCOUNTING_INCREMENTAL, LAYOUT_AOS, 1, 1 },
+    { "sjf tick",          POLICY_SJF,  0, ENGINE_TICK,  ACCOUNTING_INCREMENTAL, LAYOUT_AOS, 1, 1 },
+    { "rr4 tick",          POLICY_RR,   4, ENGINE_TICK,  ACCOUNTING_INCREMENTAL, LAYOUT_AOS, 1, 1 },
+    { "fcfs tick scan",    POLICY_FCFS, 0, ENGINE_TICK,  ACCOUNTING_SCAN,        LAYOUT_AOS, 1, 1 },
+    { "sjf tick scan",     POLICY_SJF,  0, ENGINE_TICK,  ACCOUNTING_SCAN,        LAYOUT_AOS, 1, 1 },
+    { "rr4 tick scan",     POLICY_RR,   4, ENGINE_TICK,  ACCOUNTING_SCAN,        LAYOUT_AOS, 1, 1 },
+    { "fcfs tick soa",     POLICY_FCFS, 0, ENGINE_TICK,  ACCOUNTING_SCAN,        LAYOUT_SOA, 1, 1 },
+    { "sjf tick soa",      POLICY_SJF,  0, ENGINE_TICK,  ACCOUNTING_SCAN,        LAYOUT_SOA, 1, 1 },
+    { "rr4 tick soa",      POLICY_RR,   4, ENGINE_TICK,  ACCOUNTING_SCAN,        LAYOUT_SOA, 1, 1 },
+};
+
+static const Distribution distributions[NUM_DISTRIBUTIONS] = { DIST_UNIFORM, DIST_EXPONENTIAL, DIST_PARETO };
+static const char* distribution_names[NUM_DISTRIBUTIONS] = { "uniform", "exponential", "pareto" };
+static const char* arrival_names[NUM_ARRIVALS] = { "poisson", "batch" };
+
+// Function prototypes
+static void benchmark_spec(WorkloadSpec* spec, Distribution distribution, int count, const BenchConfig* config);
+static bool write_input_file(const char* filename, const WorkloadSpec* spec);
+static double elapsed_seconds(const struct timespec* start);
+static void time_variant(const Variant* variant, const WorkloadSpec* spec, const BenchConfig* config, Measurement* result);
+static uint64_t results_digest(const Simulator* sim);
+static void compare_reference(const Simulator* sim, const Variant* variant, const WorkloadSpec* spec, Measurement* result);
+static void time_read(const char* filename, const BenchConfig* config, Measurement* result);
+static bool measure(const Variant* variant, const WorkloadSpec* spec, const char* filename, const BenchConfig* config, Measurement* result);
+static bool needed_for_events(const Variant* variant, int count, const BenchConfig* config, const char* filter);
+static void print_measurement(const char* workload, int count, const char* name, const Measurement* result, int64_t events);
+static int load_baseline(Baseline* baseline, const char* filename);
+static const BaselineEntry* find_baseline(const Baseline* baseline, const char* workload, const char* variant);
+static void add_baseline(Baseline* baseline, const char* workload, const char* variant, double events_per_second, uint64_t digest);
+static bool write_baseline(const Baseline* baseline, const char* filename);
+static int run_check(const BenchConfig* config, const char* filter, const char* baseline_name, bool record, double threshold);
+
+/**
+ * Describes a synthetic workload: bursts from the given distribution with the
+ * default mean and Poisson arrivals keeping the processor 90% busy
+ * @param spec Spec to fill in
+ * @param distribution Distribution of the bursts
+ * @param count Number of processes
+ * @param config Benchmark configuration, holding the seed
+ */
+static void benchmark_spec(WorkloadSpec* spec, Distribution distribution, int count, const BenchConfig* config) {
+    workload_default_spec(spec);
+    spec->count = count;
+    spec->burst_distribution = distribution;
+    spec->seed = config->seed;
+}
+
+/**
+ * Writes a synthetic workload as an input file
+ * @param filename File to write
+ * @param spec Workload to write
+ * @return Whether the file was written
+ */
+static bool write_input_file(const char* filename, const WorkloadSpec* spec) {
+    FILE* file = fopen(filename, "w");
+    if (file == NULL) {
+        return false;
+    }
+    bool written = write_workload(spec, file);
+    return fclose(file) == 0 && written;
+}
+
+/**
+ * Measures the time since a starting point
+ * @param start Starting point, from CLOCK_MONOTONIC
+ * @return Elapsed seconds
+ */
+static double elapsed_seconds(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+/**
+ * Times the simulation of a synthetic workload, repeating it for at least
+ * the configured time; generating the workload is not timed
+ * @param variant Configuration to run
+ * @param spec Workload to generate
+ * @param config Benchmark configuration
+ * @param result Filled in with the mean time of one run and the digest of its results
+ */
+static void time_variant(const Variant* variant, const WorkloadSpec* spec, const BenchConfig* config, Measurement* result) {
+    SimulatorOptions options;
+    simulator_default_options(&options);
+    options.engine = variant->engine;
+    options.accounting = variant->accounting;
+    options.layout = variant->layout;
+    options.num_cores = variant->num_cores;
+    options.num_threads = variant->num_threads;
+    options.trace_level = TRACE_SUMMARY;
+
+    Simulator* sim = simulator_create(&options);
+    generate_workload(sim, spec);
+    if (simulator_check_policy(sim, variant->policy) != NULL) {
+        simulator_destroy(sim);
+        return;
+    }
+
+    // Each run starts every process over, so the workload is reused
+    struct timespec start;
+    double seconds;
+    RunSummary summary;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do {
+        run_simulation(sim, variant->policy, variant->quantum);
+        result->runs++;
+        seconds = elapsed_seconds(&start);
+    } while (seconds < config->min_time);
+    summarize_run(sim, &summary);
+    result->digest = results_digest(sim);
+    result->mismatches = -1;
+    if (config->compare) {
+        compare_reference(sim, variant, spec, result);
+    }
+    simulator_destroy(sim);
+
+    result->ok = true;
+    result->seconds = seconds / result->runs;
+    result->events = summary.segments;
+}
+
+/**
+ * Hashes the wait and turnaround times of every process with FNV-1a, so that
+ * a baseline can tell whether a run still produces the same results
+ * @return Hash of the results of the last run
+ */
+static uint64_t results_digest(const Simulator* sim) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (int i = 0; i < simulator_num_processes(sim); i++) {
+        const Process* p = simulator_process(sim, i);
+        int64_t values[3] = { p->id, p->wait_time, p->turnaround_time };
+        // Hashed byte by byte from the least significant, so every build gives the same hash
+        for (int v = 0; v < 3; v++) {
+            for (int b = 0; b < 8; b++) {
+                hash ^= ((uint64_t)values[v] >> (8 * b)) & 0xff;
+                hash *= 1099511628211ULL;
+            }
+        }
+    }
+    return hash;
+}
+
+/**
+ * Runs the workload on the tick engine with scan accounting, the original
+ * per-tick loop and the reference implementation, and compares its
+ * per-process results with those of a variant; multi-core, MLFQ and CFS
+ * runs have no reference
+ * @param sim Simulator the variant ran on
+ * @param variant Variant that ran
+ * @param spec Workload the variant ran
+ * @param result Filled in with the processes that differ, -1 without a reference
+ */
+static void compare_reference(const Simulator* sim, const Variant* variant, const WorkloadSpec* spec, Measurement* result) {
+    if (variant->num_cores > 1) {
+        return;
+    }
+    SimulatorOptions options;
+    simulator_default_options(&options);
+    options.engine = ENGINE_TICK;
+    options.accounting = ACCOUNTING_SCAN;
+    options.layout = LAYOUT_AOS;
+    options.trace_level = TRACE_SUMMARY;
+    Simulator* reference = simulator_create(&options);
+    generate_workload(reference, spec);
+    if (simulator_check_policy(reference, variant->policy) != NULL) {
+        simulator_destroy(reference);
+        return;
+    }
+
+    // Both runs sort the same table by arrival, so the processes line up
+    run_simulation(reference, variant->policy, variant->quantum);
+    result->mismatches = 0;
+    for (int i = 0; i < simulator_num_processes(sim); i++) {
+        const Process* p = simulator_process(sim, i);
+        const Process* r = simulator_process(reference, i);
+        if (p->id == r->id && p->wait_time == r->wait_time && p->turnaround_time == r->turnaround_time) {
+            continue;
+        }
+        if (result->mismatches++ == 0) {
+            result->first_mismatch.id = r->id;
+            result->first_mismatch.wait_time = p->wait_time;
+            result->first_mismatch.turnaround_time = p->turnaround_time;
+            result->first_mismatch.reference_wait_time = r->wait_time;
+            result->first_mismatch.reference_turnaround_time = r->turnaround_time;
+        }
+    }
+    simulator_destroy(reference);
+}
+
+/**
+ * Times loading an input file, repeating it for at least the configured time
+ * @param filename Input file
+ * @param config Benchmark configuration
+ * @param result Filled in with the mean time of one load; events are lines
+ */
+static void time_read(const char* filename, const BenchConfig* config, Measurement* result) {
+    SimulatorOptions options;
+    simulator_default_options(&options);
+    options.trace_level = TRACE_SUMMARY;
+
+    // Only the loads are timed, each into a fresh simulator
+    double seconds = 0;
+    do {
+        Simulator* sim = simulator_create(&options);
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int malformed = read_input_file(sim, filename);
+        seconds += elapsed_seconds(&start);
+        result->events = simulator_num_processes(sim);
+        simulator_destroy(sim);
+        if (malformed != 0) {
+            return;
+        }
+        result->runs++;
+    } while (seconds < config->min_time);
+
+    result->ok = true;
+    result->seconds = seconds / result->runs;
+}
+
+/**
+ * Takes one measurement in a child process, so that its peak resident set
+ * size is its own and a failure cannot take down the benchmark
+ * @param variant Configuration to run, or NULL to time read_input_file()
+ * @param spec Workload to generate for the variant
+ * @param filename Input file holding the same workload, for read_input_file()
+ * @param config Benchmark configuration
+ * @param result Filled in with the measurement
+ * @return Whether the child reported back
+ */
+static bool measure(const Variant* variant, const WorkloadSpec* spec, const char* filename, const BenchConfig* config, Measurement* result) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    fflush(stdout);
+
+    pid_t child = fork();
+    if (child < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (child == 0) {
+        Measurement measurement = { 0 };
+        close(fds[0]);
+        if (variant != NULL) {
+            time_variant(variant, spec, config, &measurement);
+        } else {
+            time_read(filename, config, &measurement);
+        }
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        measurement.peak_rss = usage.ru_maxrss;
+        _exit(write(fds[1], &measurement, sizeof(measurement)) == sizeof(measurement) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    bool reported = read(fds[0], result, sizeof(*result)) == sizeof(*result);
+    close(fds[0]);
+    waitpid(child, NULL, 0);
+    return reported;
+}
+
+/**
+ * Checks whether a variant that was not asked for must still run because a
+ * requested tick or analytic variant takes its event count from it
+ * @param variant Variant to check
+ * @param count Number of processes
+ * @param config Benchmark configuration
+ * @param filter Substring the requested variants contain
+ * @return Whether the variant is the event run of a requested tick variant
+ */
+static bool needed_for_events(const Variant* variant, int count, const BenchConfig* config, const char* filter) {
+    if (variant->engine != ENGINE_EVENT || variant->num_cores > 1) {
+        return false;
+    }
+    for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+        if (variants[v].engine != ENGINE_EVENT && variants[v].policy == variant->policy &&
+            (variants[v].engine == ENGINE_ANALYTIC || count <= config->max_tick_processes) &&
+            strstr(variants[v].name, filter) != NULL) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Prints one line of results
+ * @param workload Name of the burst distribution
+ * @param count Number of processes
+ * @param name Name of what was timed
+ * @param result Measurement to print
+ * @param events Events of one run
+ */
+static void print_measurement(const char* workload, int count, const char* name, const Measurement* result, int64_t events) {
+    double ns_per_event = events > 0 ? result->seconds * 1e9 / events : 0;
+    double events_per_second = result->seconds > 0 ? events / result->seconds : 0;
+    printf("%-12s %9d  %-18s %11lld %10.1f %13.0f %10ld\n", workload, count, name, (long long)events,
+           ns_per_event, events_per_second, result->peak_rss);
+}
+
+/**
+ * Loads the baseline of the perf gate, one measurement per line:
+ * <workload>,<variant>,<events per second>,<digest in hex>
+ * @param baseline Baseline to add the measurements to
+ * @param filename Baseline file
+ * @return Number of malformed lines skipped, or -1 if the file cannot be read
+ */
+static int load_baseline(Baseline* baseline, const char* filename) {
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        return -1;
+    }
+    char line[BASELINE_LINE_SIZE];
+    int malformed = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char* workload = strtok(line, ",");
+        char* variant = strtok(NULL, ",");
+        char* rate = strtok(NULL, ",");
+        char* digest = strtok(NULL, ",\r\n");
+        char* end = NULL;
+        double events_per_second = rate != NULL ? strtod(rate, &end) : 0;
+        if (digest == NULL || end == rate || strlen(workload) >= sizeof(baseline->entries->workload) ||
+            strlen(variant) >= sizeof(baseline->entries->variant)) {
+            malformed++;
+            continue;
+        }
+        add_baseline(baseline, workload, variant, events_per_second, strtoull(digest, NULL, 16));
+    }
+    fclose(file);
+    return malformed;
+}
+
+/**
+ * Looks up the measurement of a variant on a workload
+ * @param baseline Baseline to search
+ * @param workload Burst distribution and arrival pattern
+ * @param variant Name of the variant
+ * @return The measurement, or NULL if the baseline has none
+ */
+static const BaselineEntry* find_baseline(const Baseline* baseline, const char* workload, const char* variant) {
+    for (int i = 0; i < baseline->count; i++) {
+        if (strcmp(baseline->entries[i].workload, workload) == 0 && strcmp(baseline->entries[i].variant, variant) == 0) {
+            return &baseline->entries[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Appends a measurement to a baseline
+ * @param baseline Baseline to grow
+ * @param workload Burst distribution and arrival pattern, shorter than BaselineEntry.workload
+ * @param variant Name of the variant, shorter than BaselineEntry.variant
+ * @param events_per_second Throughput
+ * @param digest Hash of the per-process results
+ */
+static void add_baseline(Baseline* baseline, const char* workload, const char* variant, double events_per_second, uint64_t digest) {
+    if (baseline->count == baseline->capacity) {
+        int capacity = baseline->capacity > 0 ? baseline->capacity * 2 : 64;
+        BaselineEntry* entries = realloc(baseline->entries, (size_t)capacity * sizeof(BaselineEntry));
+        if (!entries) {
+            printf("Error: Out of memory\n");
+            exit(1);
+        }
+        baseline->entries = entries;
+        baseline->capacity = capacity;
+    }
+    BaselineEntry* entry = &baseline->entries[baseline->count++];
+    snprintf(entry->workload, sizeof(entry->workload), "%s", workload);
+    snprintf(entry->variant, sizeof(entry->variant), "%s", variant);
+    entry->events_per_second = events_per_second;
+    entry->digest = digest;
+}
+
+/**
+ * Writes a baseline in the format load_baseline() reads
+ * @param baseline Baseline to write
+ * @param filename Baseline file
+ * @return Whether the file was written
+ */
+static bool write_baseline(const Baseline* baseline, const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (file == NULL) {
+        return false;
+    }
+    for (int i = 0; i < baseline->count; i++) {
+        const BaselineEntry* entry = &baseline->entries[i];
+        fprintf(file, "%s,%s,%.0f,%016llx\n", entry->workload, entry->variant, entry->events_per_second,
+                (unsigned long long)entry->digest);
+    }
+    return fclose(file) == 0;
+}
+
+/**
+ * Runs the perf gate: every variant on a corpus of workloads, each checked
+ * against the tick scan reference where there is one and against the results and
+ * throughput stored in a baseline
+ * @param config Benchmark configuration
+ * @param filter Substring the variants checked contain, NULL for all
+ * @param baseline_name Baseline file
+ * @param record Whether to write the measurements to the baseline file instead of comparing with it
+ * @param threshold Largest slowdown from the baseline that passes, in percent
+ * @return Exit status: 0 if every check passed, 1 otherwise
+ */
+static int run_check(const BenchConfig* config, const char* filter, const char* baseline_name, bool record, double threshold) {
+    Baseline baseline = { NULL, 0, 0 };
+    Baseline measured = { NULL, 0, 0 };
+    if (!record) {
+        int malformed = load_baseline(&baseline, baseline_name);
+        if (malformed < 0) {
+            fprintf(stderr, "Warning: No baseline in %s; checking against the tick scan reference only\n", baseline_name);
+        } else if (malformed > 0) {
+            fprintf(stderr, "Warning: Skipped %d malformed line%s in %s\n", malformed, malformed == 1 ? "" : "s", baseline_name);
+        }
+    }
+
+    int mismatches = 0;
+    int slowdowns = 0;
+    printf("%-20s %-18s %-9s %13s %13s %8s  %s\n", "workload", "variant", "reference", "events/sec", "baseline",
+           "change", "result");
+    for (int d = 0; d < NUM_DISTRIBUTIONS; d++) {
+        for (int a = 0; a < NUM_ARRIVALS; a++) {
+            char workload[32];
+            snprintf(workload, sizeof(workload), "%s %s", distribution_names[d], arrival_names[a]);
+            WorkloadSpec spec;
+            benchmark_spec(&spec, distributions[d], CHECK_PROCESSES, config);
+            if (a == 1) {
+                spec.mean_interarrival = 0;
+            }
+            // Segments of each policy's event run, the events of its tick and analytic runs
+            int64_t policy_events[POLICY_CFS + 1] = { 0 };
+
+            for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+                const Variant* variant = &variants[v];
+                bool borrowed = variant->engine != ENGINE_EVENT;
+                bool wanted = filter == NULL || strstr(variant->name, filter) != NULL;
+                if (!wanted && !needed_for_events(variant, CHECK_PROCESSES, config, filter)) {
+                    continue;
+                }
+                Measurement result;
+                memset(&result, 0, sizeof(result));
+                if (!measure(variant, &spec, NULL, config, &result) || !result.ok) {
+                    printf("%-20s %-18s could not be run\n", workload, variant->name);
+                    mismatches++;
+                    continue;
+                }
+                if (!borrowed && variant->num_cores == 1) {
+                    policy_events[variant->policy] = result.events;
+                }
+                if (!wanted) {
+                    continue;
+                }
+
+                int64_t events = borrowed ? policy_events[variant->policy] : result.events;
+                double events_per_second = result.seconds > 0 ? events / result.seconds : 0;
+                const BaselineEntry* entry = find_baseline(&baseline, workload, variant->name);
+                bool matches = result.mismatches <= 0 && (entry == NULL || entry->digest == result.digest);
+                double change = entry != NULL && entry->events_per_second > 0 ?
+                                (events_per_second / entry->events_per_second - 1) * 100 : 0;
+                bool slower = entry != NULL && -change > threshold;
+                char baseline_rate[16] = "-";
+                char change_text[16] = "-";
+                if (entry != NULL) {
+                    snprintf(baseline_rate, sizeof(baseline_rate), "%.0f", entry->events_per_second);
+                    snprintf(change_text, sizeof(change_text), "%+.1f%%", change);
+                }
+                printf("%-20s %-18s %-9s %13.0f %13s %8s  %s%s\n", workload, variant->name,
+                       result.mismatches < 0 ? "none" : "tick scan", events_per_second, baseline_rate, change_text,
+                       matches ? "ok" : "MISMATCH", slower ? " SLOWER" : "");
+                if (result.mismatches > 0) {
+                    const Mismatch* m = &result.first_mismatch;
+                    printf("    %d process%s differ%s from the tick scan reference, first P%d: wait %lld, turnaround %lld"
+                           " instead of %lld, %lld\n", result.mismatches, result.mismatches == 1 ? "" : "es",
+                           result.mismatches == 1 ? "s" : "", m->id, (long long)m->wait_time,
+                           (long long)m->turnaround_time, (long long)m->reference_wait_time,
+                           (long long)m->reference_turnaround_time);
+                } else if (!matches) {
+                    printf("    Results differ from the baseline\n");
+                }
+                mismatches += !matches;
+                slowdowns += slower;
+                add_baseline(&measured, workload, variant->name, events_per_second, result.digest);
+            }
+        }
+    }
+
+    int status = mismatches > 0 || slowdowns > 0;
+    if (record) {
+        // A baseline of wrong results would pass them from then on
+        if (mismatches > 0) {
+            printf("Error: Not recording a baseline with mismatched results\n");
+        } else if (!write_baseline(&measured, baseline_name)) {
+            printf("Error: Could not write %s\n", baseline_name);
+            status = 1;
+        } else {
+            printf("\nRecorded %d measurement%s in %s\n", measured.count, measured.count == 1 ? "" : "s", baseline_name);
+        }
+    } else {
+        printf("\n%d mismatch%s, %d slowdown%s of more than %.0f%%\n", mismatches, mismatches == 1 ? "" : "es",
+               slowdowns, slowdowns == 1 ? "" : "s", threshold);
+    }
+    free(baseline.entries);
+    free(measured.entries);
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    BenchConfig config = { 10000000, 10000, 1, 0.2, false };
+    const char* filter = NULL;                 // Substring variants must contain, if any
+    const char* baseline_name = NULL;          // Baseline of the perf gate, NULL to benchmark
+    bool record = false;                       // Whether to record the baseline instead of checking it
+    double threshold = 25;                     // Largest slowdown the perf gate passes, in percent
+
+    for (int arg = 1; arg < argc; arg++) {
+        if (strncmp(argv[arg], "--max=", strlen("--max=")) == 0) {
+            config.max_processes = atoi(argv[arg] + strlen("--max="));
+            if (config.max_processes < 100) {
+                printf("Error: The largest workload must have at least 100 processes\n");
+                return 1;
+            }
+        } else if (strncmp(argv[arg], "--max-tick=", strlen("--max-tick=")) == 0) {
+            config.max_tick_processes = atoi(argv[arg] + strlen("--max-tick="));
+        } else if (strncmp(argv[arg], "--seed=", strlen("--seed=")) == 0) {
+            config.seed = strtoull(argv[arg] + strlen("--seed="), NULL, 10);
+        } else if (strncmp(argv[arg], "--min-time=", strlen("--min-time=")) == 0) {
+            config.min_time = atof(argv[arg] + strlen("--min-time="));
+        } else if (strncmp(argv[arg], "--only=", strlen("--only=")) == 0) {
+            filter = argv[arg] + strlen("--only=");
+        } else if (strncmp(argv[arg], "--check=", strlen("--check=")) == 0) {
+            baseline_name = argv[arg] + strlen("--check=");
+            record = false;
+        } else if (strncmp(argv[arg], "--record=", strlen("--record=")) == 0) {
+            baseline_name = argv[arg] + strlen("--record=");
+            record = true;
+        } else if (strncmp(argv[arg], "--threshold=", strlen("--threshold=")) == 0) {
+            threshold = atof(argv[arg] + strlen("--threshold="));
+            if (threshold <= 0) {
+                printf("Error: The slowdown threshold must be positive\n");
+                return 1;
+            }
+        } else {
+            printf("Usage: %s [--max=<count>] [--max-tick=<count>] [--seed=<seed>] [--min-time=<seconds>] [--only=<name>]\n", argv[0]);
+            printf("       %s --check=<baseline>|--record=<baseline> [--threshold=<percent>] [--seed=<seed>] [--min-time=<seconds>] [--only=<name>]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (baseline_name != NULL) {
+        config.compare = true;
+        return run_check(&config, filter, baseline_name, record, threshold);
+    }
+
+    char filename[] = "/tmp/scheduler-bench-XXXXXX";
+    int fd = mkstemp(filename);
+    if (fd < 0) {
+        printf("Error: Could not create a temporary input file\n");
+        return 1;
+    }
+    close(fd);
+
+    printf("%-12s %9s  %-18s %11s %10s %13s %10s\n", "workload", "processes", "variant", "events", "ns/event",
+           "events/sec", "peak KB");
+    for (int d = 0; d < NUM_DISTRIBUTIONS; d++) {
+        for (int count = 100; ; count *= 10) {
+            // Segments of each policy's event run, the events of its tick and analytic runs
+            int64_t policy_events[POLICY_CFS + 1] = { 0 };
+            Measurement result;
+            WorkloadSpec spec;
+            benchmark_spec(&spec, distributions[d], count, &config);
+
+            if (filter == NULL || strstr("read_input_file", filter) != NULL) {
+                if (!write_input_file(filename, &spec)) {
+                    printf("Error: Could not write %s\n", filename);
+                    unlink(filename);
+                    return 1;
+                }
+                memset(&result, 0, sizeof(result));
+                if (measure(NULL, &spec, filename, &config, &result) && result.ok) {
+                    print_measurement(distribution_names[d], count, "read_input_file", &result, result.events);
+                }
+            }
+
+            for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+                const Variant* variant = &variants[v];
+                bool tick = variant->engine == ENGINE_TICK;
+                bool borrowed = variant->engine != ENGINE_EVENT;
+                if (tick && count > config.max_tick_processes) {
+                    continue;
+                }
+                // Tick and analytic runs need the event run of their policy for an event count
+                bool wanted = filter == NULL || strstr(variant->name, filter) != NULL;
+                if (!wanted && !needed_for_events(variant, count, &config, filter)) {
+                    continue;
+                }
+                memset(&result, 0, sizeof(result));
+                if (!measure(variant, &spec, NULL, &config, &result) || !result.ok) {
+                    continue;
+                }
+                if (!borrowed && variant->num_cores == 1) {
+                    policy_events[variant->policy] = result.events;
+                }
+                if (wanted) {
+                    print_measurement(distribution_names[d], count, variant->name, &result,
+                                      borrowed ? policy_events[variant->policy] : result.events);
+                }
+            }
+            if (count > config.max_processes / 10) {
+                break;
+            }
+        }
+    }
+    unlink(filename);
+    return 0;
+}
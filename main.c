@@ -0,0 +1,974 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "scheduler.h"
+#include "server.h"
+
+// One configuration of a parameter sweep
+typedef struct {
+    Policy policy;          // Scheduling policy
+    int quantum;            // Time quantum for Round Robin, 0 otherwise
+    RunSummary summary;     // Results, filled in by a worker thread
+} SweepConfig;
+
+// Work shared by the threads of a parameter sweep
+typedef struct {
+    const Simulator* workload;  // Simulator holding the loaded processes, shared read-only
+    SimulatorOptions options;   // Options every configuration runs with
+    SweepConfig* configs;       // Configurations to run
+    int num_configs;            // Number of configurations
+    atomic_int next_config;     // Index of the next configuration to claim
+} SweepJob;
+
+// Function prototypes
+void print_policy_header(const SimulatorOptions* options, Policy policy, int quantum);
+bool parse_mlfq_quanta(const char* spec, SimulatorOptions* options);
+bool parse_distribution(const char* spec, Distribution* distribution, double* mean);
+int parse_sweep(const char* spec, SweepConfig** configs);
+void* sweep_worker(void* arg);
+void run_sweep(const Simulator* workload, const SimulatorOptions* options, SweepConfig* configs, int num_configs, int num_threads);
+int load_workload(Simulator* sim, const char* filename, int reserve, const WorkloadSpec* generated);
+int stream_workload(Simulator* sim, const SimulatorOptions* options, Policy policy, int quantum, const char* filename, int report_interval);
+void print_stats(const SimulatorStats* stats);
+int print_what_ifs(Simulator* sim, const char* filename);
+
+/**
+ * Prints the name of a scheduling policy ahead of its trace
+ * @param options Options holding the MLFQ and CFS configuration
+ * @param policy Scheduling policy
+ * @param quantum Time quantum for Round Robin
+ */
+void print_policy_header(const SimulatorOptions* options, Policy policy, int quantum) {
+    switch (policy) {
+    case POLICY_FCFS:
+        printf("First Come First Served\n");
+        break;
+    case POLICY_SJF:
+        printf("Shortest Job First\n");
+        break;
+    case POLICY_RR:
+        printf("Round Robin with Quantum %d\n", quantum);
+        break;
+    case POLICY_MLFQ:
+        printf("Multi-Level Feedback Queue with Quanta ");
+        for (int l = 0; l < options->mlfq_levels; l++) {
+            printf(l > 0 ? ",%d" : "%d", options->mlfq_quanta[l]);
+        }
+        if (options->mlfq_boost_period > 0) {
+            printf(" and Boost Period %d", options->mlfq_boost_period);
+        }
+        printf("\n");
+        break;
+    case POLICY_CFS:
+        printf("Completely Fair Scheduler with Latency %d and Minimum Granularity %d\n",
+               options->cfs_latency, options->cfs_min_granularity);
+        break;
+    }
+}
+
+/**
+ * Parses the per-level quanta of a multi-level feedback queue
+ * Format: comma-separated positive quanta, from the highest priority down
+ * @param spec Quanta specification
+ * @param options Receives the number of levels and their quanta
+ * @return false if the specification is invalid
+ */
+bool parse_mlfq_quanta(const char* spec, SimulatorOptions* options) {
+    int levels = 0;
+    const char* c = spec;
+
+    for (;;) {
+        char* end;
+        long quantum = strtol(c, &end, 10);
+        if (end == c || quantum <= 0 || quantum > INT_MAX || levels == MLFQ_MAX_LEVELS) {
+            return false;
+        }
+        options->mlfq_quanta[levels++] = (int)quantum;
+        if (*end == '\0') {
+            options->mlfq_levels = levels;
+            return true;
+        }
+        if (*end != ',') {
+            return false;
+        }
+        c = end + 1;
+    }
+}
+
+/**
+ * Parses the distribution of generated bursts or gaps between arrivals
+ * Format: constant, uniform, exponential or pareto, optionally followed by
+ * a colon and the mean, which is otherwise left unchanged
+ * @param spec Distribution specification
+ * @param distribution Receives the distribution
+ * @param mean Receives the mean, if given
+ * @return false if the specification is invalid
+ */
+bool parse_distribution(const char* spec, Distribution* distribution, double* mean) {
+    static const char* names[] = { "constant", "uniform", "exponential", "pareto" };
+    const char* colon = strchr(spec, ':');
+    size_t length = colon != NULL ? (size_t)(colon - spec) : strlen(spec);
+
+    for (int d = 0; d < (int)(sizeof(names) / sizeof(names[0])); d++) {
+        if (strlen(names[d]) != length || strncmp(spec, names[d], length) != 0) {
+            continue;
+        }
+        if (colon != NULL) {
+            char* end;
+            double value = strtod(colon + 1, &end);
+            if (end == colon + 1 || *end != '\0') {
+                return false;
+            }
+            *mean = value;
+        }
+        *distribution = (Distribution)d;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Parses the configurations of a parameter sweep
+ * Format: comma-separated entries, each f (FCFS), s (SJF), m (MLFQ with the
+ * configured levels), c (CFS), r<quantum> or r<first>..<last> (Round Robin with every
+ * quantum in the range)
+ * @param spec Sweep specification
+ * @param configs Receives the allocated array of configurations
+ * @return Number of configurations, or -1 if the specification is invalid
+ */
+int parse_sweep(const char* spec, SweepConfig** configs) {
+    int count = 0;
+    int capacity = 16;
+    SweepConfig* list = malloc(capacity * sizeof(SweepConfig));
+    const char* c = spec;
+
+    while (list) {
+        Policy policy;
+        long first = 0;
+        long last = 0;
+        char* end;
+
+        if (*c == 'f' || *c == 's' || *c == 'm' || *c == 'c') {
+            policy = *c == 'f' ? POLICY_FCFS : *c == 's' ? POLICY_SJF : *c == 'm' ? POLICY_MLFQ : POLICY_CFS;
+            c++;
+        } else if (*c == 'r') {
+            policy = POLICY_RR;
+            first = strtol(c + 1, &end, 10);
+            if (end == c + 1 || first <= 0 || first > INT_MAX) {
+                break;
+            }
+            last = first;
+            c = end;
+            if (c[0] == '.' && c[1] == '.') {
+                last = strtol(c + 2, &end, 10);
+                if (end == c + 2 || last < first || last > INT_MAX) {
+                    break;
+                }
+                c = end;
+            }
+        } else {
+            break;
+        }
+
+        for (long quantum = first; quantum <= last; quantum++) {
+            if (count == capacity) {
+                capacity *= 2;
+                SweepConfig* grown = realloc(list, capacity * sizeof(SweepConfig));
+                if (!grown) {
+                    printf("Error: Out of memory\n");
+                    exit(1);
+                }
+                list = grown;
+            }
+            list[count].policy = policy;
+            list[count].quantum = (int)quantum;
+            count++;
+        }
+
+        if (*c == '\0') {
+            *configs = list;
+            return count;
+        }
+        if (*c++ != ',') {
+            break;
+        }
+    }
+
+    if (!list) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    free(list);
+    return -1;
+}
+
+/**
+ * Thread body of a parameter sweep
+ * Claims configurations until none are left, simulating each on a private
+ * simulator holding a copy of the workload that is reused between runs
+ * @param arg The shared SweepJob
+ * @return NULL
+ */
+void* sweep_worker(void* arg) {
+    SweepJob* job = arg;
+    Simulator* sim = simulator_create(&job->options);
+    simulator_copy_workload(sim, job->workload);
+
+    for (;;) {
+        int i = atomic_fetch_add(&job->next_config, 1);
+        if (i >= job->num_configs) {
+            break;
+        }
+        run_simulation(sim, job->configs[i].policy, job->configs[i].quantum);
+        summarize_run(sim, &job->configs[i].summary);
+    }
+
+    simulator_destroy(sim);
+    return NULL;
+}
+
+/**
+ * Runs every configuration of a sweep on a loaded process table and
+ * prints one summary row per configuration, in the order given
+ * @param workload Simulator holding the loaded processes
+ * @param options Options every configuration runs with
+ * @param configs Configurations to run
+ * @param num_configs Number of configurations
+ * @param num_threads Number of worker threads
+ */
+void run_sweep(const Simulator* workload, const SimulatorOptions* options, SweepConfig* configs, int num_configs, int num_threads) {
+    SweepJob job;
+    job.workload = workload;
+    job.options = *options;
+    job.options.trace_level = TRACE_SUMMARY;
+    job.configs = configs;
+    job.num_configs = num_configs;
+    atomic_init(&job.next_config, 0);
+
+    if (num_threads > num_configs) {
+        num_threads = num_configs;
+    }
+    pthread_t* threads = malloc((size_t)num_threads * sizeof(pthread_t));
+    if (num_threads > 0 && !threads) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    for (int t = 0; t < num_threads; t++) {
+        if (pthread_create(&threads[t], NULL, sweep_worker, &job) != 0) {
+            printf("Error: Could not start worker thread\n");
+            exit(1);
+        }
+    }
+    for (int t = 0; t < num_threads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+
+    static const char* policy_names[] = { "fcfs", "sjf", "rr", "mlfq", "cfs" };
+    printf("policy,quantum,average_wait_time,average_turnaround_time,makespan\n");
+    for (int i = 0; i < num_configs; i++) {
+        printf("%s,%d,%.3f,%.3f,%lld\n",
+            policy_names[configs[i].policy],
+            configs[i].quantum,
+            configs[i].summary.average_wait_time,
+            configs[i].summary.average_turnaround_time,
+            (long long)configs[i].summary.makespan);
+    }
+}
+
+
+/**
+ * Reads the input file into a simulator, warning about skipped lines,
+ * or fills it with a generated workload
+ * @param sim Simulator to fill
+ * @param filename Name of the input CSV file
+ * @param reserve Expected number of processes, 0 if unknown
+ * @param generated Workload to generate instead of reading a file, or NULL
+ * @return 0 on success, 1 if the file cannot be read
+ */
+int load_workload(Simulator* sim, const char* filename, int reserve, const WorkloadSpec* generated) {
+    if (generated != NULL) {
+        generate_workload(sim, generated);
+        return 0;
+    }
+
+    // Pre-size the table when the count is known
+    reserve_processes(sim, reserve);
+    int malformed = read_input_file(sim, filename);
+    if (malformed < 0) {
+        printf("Error: Could not open file %s\n", filename);
+        return 1;
+    }
+    if (malformed > 0) {
+        fprintf(stderr, "Warning: Skipped %d malformed line%s in %s\n", malformed, malformed == 1 ? "" : "s", filename);
+    }
+    return 0;
+}
+
+/**
+ * Simulates jobs streamed from a file, pipe or standard input and prints the averages
+ * @param sim Simulator to run
+ * @param options Options the simulator was created with
+ * @param policy Scheduling policy, see simulator_check_stream()
+ * @param quantum Time quantum for Round Robin
+ * @param filename Name of the input, or - for standard input
+ * @param report_interval Time units between reports of the running averages, 0 for none
+ * @return 0 on success, 1 if the input cannot be read
+ */
+int stream_workload(Simulator* sim, const SimulatorOptions* options, Policy policy, int quantum, const char* filename, int report_interval) {
+    bool use_stdin = strcmp(filename, "-") == 0;
+    int fd = use_stdin ? STDIN_FILENO : open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Could not open file %s\n", filename);
+        return 1;
+    }
+    print_policy_header(options, policy, quantum);
+
+    RunSummary summary;
+    int malformed = run_stream(sim, policy, quantum, fd, report_interval, &summary);
+    if (!use_stdin) {
+        close(fd);
+    }
+    if (malformed < 0) {
+        printf("Error: Could not read %s\n", filename);
+        return 1;
+    }
+    if (malformed > 0) {
+        fprintf(stderr, "Warning: Skipped %d malformed line%s in %s\n", malformed, malformed == 1 ? "" : "s", filename);
+    }
+    printf("\nTotal average waiting time:\t%.1f\n", summary.average_wait_time);
+    printf("Total average turnaround time:\t%.1f\n", summary.average_turnaround_time);
+    return 0;
+}
+
+/**
+ * Prints the instrumentation counters and phase timings after a run
+ * @param stats Counters from simulator_stats()
+ */
+void print_stats(const SimulatorStats* stats) {
+    printf("\nContext switches:\t%lld\n", (long long)stats->context_switches);
+    printf("Preemptions:\t\t%lld\n", (long long)stats->preemptions);
+    printf("Ready high-water mark:\t%d\n", stats->max_ready);
+    printf("Selection scan steps:\t%lld\n", (long long)stats->scan_iterations);
+    printf("Ticks simulated:\t%lld\n", (long long)stats->ticks);
+    printf("Events processed:\t%lld\n", (long long)stats->events);
+    printf("Shards stolen:\t\t%lld\n", (long long)stats->shard_steals);
+    printf("Load time:\t\t%.3f ms\n", stats->load_seconds * 1e3);
+    printf("Simulation time:\t%.3f ms\n", stats->simulate_seconds * 1e3);
+    printf("Report time:\t\t%.3f ms\n", stats->report_seconds * 1e3);
+}
+
+/**
+ * Runs the what-if edits listed in a file against the run that just finished
+ * and prints the results of each
+ * File format: one edit per line, P<id>,<burst_time>, giving a process a
+ * different first CPU burst
+ * @param sim Simulator whose last run was recorded with simulator_set_snapshots()
+ * @param filename Name of the file of edits
+ * @return 0 on success, 1 if the file cannot be read or has an invalid edit
+ */
+int print_what_ifs(Simulator* sim, const char* filename) {
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        printf("Error: Could not open file %s\n", filename);
+        return 1;
+    }
+
+    char line[256];
+    int line_number = 0;
+    bool first = true;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        const char* c = line;
+        while (*c == ' ' || *c == '\t') {
+            c++;
+        }
+        if (*c == '\n' || *c == '\r' || *c == '\0') {
+            continue;
+        }
+
+        char* end = (char*)c;
+        long id = -1;
+        long long burst_time = 0;
+        if (c[0] == 'P') {
+            id = strtol(c + 1, &end, 10);
+            if (end != c + 1 && *end == ',' && id >= 0) {
+                burst_time = strtoll(end + 1, &end, 10);
+            }
+        }
+        while (*end == ' ' || *end == '\t' || *end == '\r' || *end == '\n') {
+            end++;
+        }
+        if (burst_time <= 0 || burst_time > SIM_TIME_MAX || *end != '\0') {
+            printf("Error: Invalid what-if edit on line %d of %s\n", line_number, filename);
+            fclose(file);
+            return 1;
+        }
+        if (id >= simulator_num_processes(sim)) {
+            printf("Error: No process P%ld on line %d of %s\n", id, line_number, filename);
+            fclose(file);
+            return 1;
+        }
+
+        RunSummary summary;
+        int resimulated = run_what_if(sim, (int)id, (SimTime)burst_time, &summary);
+        printf("%sWhat-if P%ld burst %lld : average waiting time %.1f, average turnaround time %.1f, makespan %lld, %d process%s re-simulated\n",
+               first ? "\n" : "", id, burst_time, summary.average_wait_time, summary.average_turnaround_time,
+               (long long)summary.makespan, resimulated, resimulated == 1 ? "" : "es");
+        first = false;
+    }
+    fclose(file);
+    return 0;
+}
+
+/**
+ * Main function - Entry point of the program
+ * Handles command line arguments and runs selected scheduling algorithm
+ */
+int main(int argc, char *argv[]) {
+    SimulatorOptions options;         // Engine, accounting, layout and trace level
+    const char* accounting_option = NULL; // Requested accounting mode, if any
+    int reserve = 0;                  // Expected number of processes, if known
+    const char* binary_trace_name = NULL; // File to write the binary segment trace to, if any
+    const char* sweep_spec = NULL;    // Configurations of a parameter sweep, if any
+    int num_threads = 0;              // Worker threads for a sweep, sharded run, server or analytic run (0: one per CPU)
+    bool sharded = false;             // Whether each partition is simulated separately
+    bool streaming = false;           // Whether jobs are simulated as they are read
+    int report_interval = 0;          // Time units between streaming reports (0: none)
+    WorkloadSpec spec;                // Workload to generate instead of reading a file
+    bool generating = false;          // Whether the workload is generated
+    const char* emit_name = NULL;     // File to write the generated workload to, if any
+    const char* convert_name = NULL;  // File to write the workload to in the columnar format, if any
+    bool show_stats = false;          // Whether to print the instrumentation counters
+    bool show_percentiles = false;    // Whether to print percentiles of the per-process times
+    const char* checkpoint_name = NULL; // File to write periodic checkpoints to, if any
+    double checkpoint_interval = 5;   // Seconds between checkpoints
+    const char* resume_name = NULL;   // Checkpoint to continue a run from, if any
+    const char* serve_path = NULL;    // Socket to serve queries on, if any
+    int cache_size = 16;              // Workloads the server keeps parsed
+    const char* what_if_name = NULL;  // File of what-if edits to run after the simulation, if any
+    int snapshot_interval = 64;       // Fewest event loop iterations between what-if snapshots
+    int arg = 1;                      // Index of the next argument to parse
+
+    simulator_default_options(&options);
+    workload_default_spec(&spec);
+
+    // Parse options preceding the algorithm
+    while (arg < argc && strncmp(argv[arg], "--", 2) == 0) {
+        if (strcmp(argv[arg], "--engine=tick") == 0) {
+            options.engine = ENGINE_TICK;
+        } else if (strcmp(argv[arg], "--engine=event") == 0) {
+            options.engine = ENGINE_EVENT;
+        } else if (strcmp(argv[arg], "--engine=analytic") == 0) {
+            options.engine = ENGINE_ANALYTIC;
+        } else if (strcmp(argv[arg], "--accounting=scan") == 0 ||
+                   strcmp(argv[arg], "--accounting=incremental") == 0) {
+            accounting_option = argv[arg] + strlen("--accounting=");
+        } else if (strcmp(argv[arg], "--layout=aos") == 0) {
+            options.layout = LAYOUT_AOS;
+        } else if (strcmp(argv[arg], "--layout=soa") == 0) {
+            options.layout = LAYOUT_SOA;
+        } else if (strcmp(argv[arg], "--simd=auto") == 0) {
+            options.allow_simd = true;
+        } else if (strcmp(argv[arg], "--simd=off") == 0) {
+            options.allow_simd = false;
+        } else if (strcmp(argv[arg], "--trace=full") == 0) {
+            options.trace_level = TRACE_FULL;
+        } else if (strcmp(argv[arg], "--trace=segments") == 0) {
+            options.trace_level = TRACE_SEGMENTS;
+        } else if (strcmp(argv[arg], "--trace=off") == 0) {
+            options.trace_level = TRACE_OFF;
+        } else if (strcmp(argv[arg], "--trace=summary") == 0) {
+            options.trace_level = TRACE_SUMMARY;
+        } else if (strncmp(argv[arg], "--binary-trace=", strlen("--binary-trace=")) == 0) {
+            binary_trace_name = argv[arg] + strlen("--binary-trace=");
+        } else if (strncmp(argv[arg], "--dump-trace=", strlen("--dump-trace=")) == 0) {
+            // Decode a binary trace instead of running a simulation
+            return dump_binary_trace(argv[arg] + strlen("--dump-trace="));
+        } else if (strncmp(argv[arg], "--sweep=", strlen("--sweep=")) == 0) {
+            sweep_spec = argv[arg] + strlen("--sweep=");
+        } else if (strcmp(argv[arg], "--shards") == 0) {
+            sharded = true;
+        } else if (strcmp(argv[arg], "--stream") == 0) {
+            streaming = true;
+        } else if (strncmp(argv[arg], "--stream=", strlen("--stream=")) == 0) {
+            streaming = true;
+            report_interval = atoi(argv[arg] + strlen("--stream="));
+            if (report_interval <= 0) {
+                printf("Error: Report interval must be positive\n");
+                return 1;
+            }
+        } else if (strncmp(argv[arg], "--threads=", strlen("--threads=")) == 0) {
+            num_threads = atoi(argv[arg] + strlen("--threads="));
+            if (num_threads <= 0) {
+                printf("Error: Thread count must be positive\n");
+                return 1;
+            }
+        } else if (strncmp(argv[arg], "--cores=", strlen("--cores=")) == 0) {
+            options.num_cores = atoi(argv[arg] + strlen("--cores="));
+            if (options.num_cores <= 0) {
+                printf("Error: Core count must be positive\n");
+                return 1;
+            }
+        } else if (strcmp(argv[arg], "--steal=on") == 0) {
+            options.work_stealing = true;
+        } else if (strcmp(argv[arg], "--steal=off") == 0) {
+            options.work_stealing = false;
+        } else if (strncmp(argv[arg], "--migration-cost=", strlen("--migration-cost=")) == 0) {
+            options.migration_cost = atoi(argv[arg] + strlen("--migration-cost="));
+            if (options.migration_cost < 0) {
+                printf("Error: Migration cost cannot be negative\n");
+                return 1;
+            }
+        } else if (strncmp(argv[arg], "--mlfq=", strlen("--mlfq=")) == 0) {
+            if (!parse_mlfq_quanta(argv[arg] + strlen("--mlfq="), &options)) {
+                printf("Error: Invalid MLFQ quanta %s\n", argv[arg] + strlen("--mlfq="));
+                return 1;
+            }
+        } else if (strncmp(argv[arg], "--boost=", strlen("--boost=")) == 0) {
+            options.mlfq_boost_period = atoi(argv[arg] + strlen("--boost="));
+            if (options.mlfq_boost_period <= 0) {
+                printf("Error: Boost period must be positive\n");
+                return 1;
+            }
+        } else if (strncmp(argv[arg], "--cfs-latency=", strlen("--cfs-latency=")) == 0) {
+            options.cfs_latency = atoi(argv[arg] + strlen("--cfs-latency="));
+            if (options.cfs_latency <= 0) {
+                printf("Error: CFS latency must be positive\n");
+                return 1;
+            }
+        } else if (strncmp(argv[arg], "--min-granularity=", strlen("--min-granularity=")) == 0) {
+            options.cfs_min_granularity = atoi(argv[arg] + strlen("--min-granularity="));
+            if (options.cfs_min_granularity <= 0) {
+                printf("Error: Minimum granularity must be positive\n");
+                return 1;
+            }
+        } else if (strncmp(argv[arg], "--generate=", strlen("--generate=")) == 0) {
+            generating = true;
+            spec.count = atoi(argv[arg] + strlen("--generate="));
+            if (spec.count <= 0) {
+                printf("Error: Generated process count must be positive\n");
+                return 1;
+            }
+        } else if (strncmp(argv[arg], "--bursts=", strlen("--bursts=")) == 0) {
+            if (!parse_distribution(argv[arg] + strlen("--bursts="), &spec.burst_distribution, &spec.mean_burst)) {
+                printf("Error: Invalid burst distribution %s\n", argv[arg] + strlen("--bursts="));
+                return 1;
+            }
+        } else if (strncmp(argv[arg], "--arrivals=", strlen("--arrivals=")) == 0) {
+            if (!parse_distribution(argv[arg] + strlen("--arrivals="), &spec.arrival_distribution, &spec.mean_interarrival)) {
+                printf("Error: Invalid arrival distribution %s\n", argv[arg] + strlen("--arrivals="));
+                return 1;
+            }
+        } else if (strncmp(argv[arg], "--seed=", strlen("--seed=")) == 0) {
+            spec.seed = strtoull(argv[arg] + strlen("--seed="), NULL, 10);
+        } else if (strncmp(argv[arg], "--emit=", strlen("--emit=")) == 0) {
+            emit_name = argv[arg] + strlen("--emit=");
+        } else if (strncmp(argv[arg], "--convert=", strlen("--convert=")) == 0) {
+            convert_name = argv[arg] + strlen("--convert=");
+        } else if (strncmp(argv[arg], "--checkpoint=", strlen("--checkpoint=")) == 0) {
+            checkpoint_name = argv[arg] + strlen("--checkpoint=");
+        } else if (strncmp(argv[arg], "--checkpoint-interval=", strlen("--checkpoint-interval=")) == 0) {
+            checkpoint_interval = atof(argv[arg] + strlen("--checkpoint-interval="));
+            if (checkpoint_interval < 0) {
+                printf("Error: Checkpoint interval cannot be negative\n");
+                return 1;
+            }
+        } else if (strncmp(argv[arg], "--resume=", strlen("--resume=")) == 0) {
+            resume_name = argv[arg] + strlen("--resume=");
+        } else if (strncmp(argv[arg], "--serve=", strlen("--serve=")) == 0) {
+            serve_path = argv[arg] + strlen("--serve=");
+        } else if (strncmp(argv[arg], "--cache=", strlen("--cache=")) == 0) {
+            cache_size = atoi(argv[arg] + strlen("--cache="));
+            if (cache_size <= 0) {
+                printf("Error: Cache size must be positive\n");
+                return 1;
+            }
+        } else if (strncmp(argv[arg], "--what-if=", strlen("--what-if=")) == 0) {
+            what_if_name = argv[arg] + strlen("--what-if=");
+        } else if (strncmp(argv[arg], "--snapshot-interval=", strlen("--snapshot-interval=")) == 0) {
+            snapshot_interval = atoi(argv[arg] + strlen("--snapshot-interval="));
+            if (snapshot_interval <= 0) {
+                printf("Error: Snapshot interval must be positive\n");
+                return 1;
+            }
+        } else if (strcmp(argv[arg], "--percentiles") == 0) {
+            show_percentiles = true;
+        } else if (strcmp(argv[arg], "--stats") == 0) {
+            show_stats = true;
+        } else if (strncmp(argv[arg], "--reserve=", strlen("--reserve=")) == 0) {
+            reserve = atoi(argv[arg] + strlen("--reserve="));
+            if (reserve <= 0) {
+                printf("Error: Reserve count must be positive\n");
+                return 1;
+            }
+        } else {
+            printf("Error: Invalid option %s\n", argv[arg]);
+            return 1;
+        }
+        arg++;
+    }
+
+    // A generated workload can be written out instead of simulated
+    if (emit_name != NULL) {
+        const char* problem = generating ? workload_check_spec(&spec) : "--emit requires --generate";
+        if (problem != NULL) {
+            printf("Error: %s\n", problem);
+            return 1;
+        }
+        bool use_stdout = strcmp(emit_name, "-") == 0;
+        FILE* file = use_stdout ? stdout : fopen(emit_name, "w");
+        if (file == NULL) {
+            printf("Error: Could not create file %s\n", emit_name);
+            return 1;
+        }
+        bool written = write_workload(&spec, file);
+        if (!use_stdout && fclose(file) != 0) {
+            written = false;
+        }
+        if (!written) {
+            printf("Error: Could not write %s\n", emit_name);
+            return 1;
+        }
+        return 0;
+    }
+
+    // The input file or a generated workload can be converted to the columnar format
+    if (convert_name != NULL) {
+        if (argc - arg != (generating ? 0 : 1)) {
+            printf("Error: --convert takes one input file, or --generate instead\n");
+            return 1;
+        }
+        const char* problem = generating ? workload_check_spec(&spec) : NULL;
+        if (problem != NULL) {
+            printf("Error: %s\n", problem);
+            return 1;
+        }
+        SimulatorOptions defaults;
+        simulator_default_options(&defaults);
+        Simulator* sim = simulator_create(&defaults);
+        if (load_workload(sim, generating ? NULL : argv[arg], reserve, generating ? &spec : NULL) != 0) {
+            return 1;
+        }
+        for (int i = 0; i < simulator_num_processes(sim); i++) {
+            const Process* p = simulator_process(sim, i);
+            if (p->num_phases > 0) {
+                printf("Error: The columnar format has no I/O bursts\n");
+                return 1;
+            }
+            if (p->burst_time > INT32_MAX || p->arrival_time > INT32_MAX) {
+                printf("Error: The columnar format has no times past %d\n", INT32_MAX);
+                return 1;
+            }
+        }
+        FILE* file = fopen(convert_name, "wb");
+        if (file == NULL) {
+            printf("Error: Could not create file %s\n", convert_name);
+            return 1;
+        }
+        bool written = write_workload_columns(sim, file, true);
+        if (fclose(file) != 0) {
+            written = false;
+        }
+        simulator_destroy(sim);
+        if (!written) {
+            printf("Error: Could not write %s\n", convert_name);
+            return 1;
+        }
+        return 0;
+    }
+
+    // Check for minimum number of arguments; a generated workload has no input file,
+    // and a resumed run takes its workload and algorithm from the checkpoint
+    int inputs = generating ? 0 : 1;
+    if (resume_name == NULL && serve_path == NULL && argc - arg < (sweep_spec != NULL ? 0 : 1) + inputs) {
+        printf("Usage: %s [options] [-f|-s|-r <quantum>|-m|-c] <input_file>\n", argv[0]);
+        printf("       %s [options] --sweep=<f|s|m|c|r<q>|r<first>..<last>>[,...] [--threads=<count>] <input_file>\n", argv[0]);
+        printf("       %s [options] --generate=<count> [--bursts=<distribution>] [--arrivals=<distribution>] [--seed=<seed>]\n", argv[0]);
+        printf("          [-f|-s|-r <quantum>|-m|-c|--sweep=<configurations>|--emit=<file>] (without an input file)\n");
+        printf("       %s [options] --resume=<checkpoint>\n", argv[0]);
+        printf("       %s [--generate=<count> ...] --convert=<columnar file> [<input_file>]\n", argv[0]);
+        printf("       %s [options] --serve=<socket> [--threads=<count>] [--cache=<count>]\n", argv[0]);
+        printf("Options: [--engine=tick|event|analytic [--threads=<count>]] [--accounting=scan|incremental] [--layout=aos|soa] [--simd=auto|off]\n");
+        printf("         [--trace=full|segments|off|summary] [--binary-trace=<file>] [--reserve=<count>]\n");
+        printf("         [--cores=<count>] [--steal=on|off] [--migration-cost=<time>] [--dump-trace=<file>]\n");
+        printf("         [--mlfq=<quantum>[,...]] [--boost=<period>] [--cfs-latency=<time>] [--min-granularity=<time>]\n");
+        printf("         [--stream[=<report interval>]] (with - as the input file for standard input) [--percentiles] [--stats]\n");
+        printf("         [--checkpoint=<file>] [--checkpoint-interval=<seconds>] [--shards [--threads=<count>]]\n");
+        printf("         [--what-if=<file>] [--snapshot-interval=<iterations>]\n");
+        printf("Distributions: constant|uniform|exponential|pareto[:<mean>]\n");
+        return 1;
+    }
+
+    // The tick engine scans by default; the event engine derives times from timestamps
+    if (accounting_option == NULL) {
+        options.accounting = options.engine == ENGINE_TICK ? ACCOUNTING_SCAN : ACCOUNTING_INCREMENTAL;
+    } else if (strcmp(accounting_option, "scan") == 0) {
+        options.accounting = ACCOUNTING_SCAN;
+    } else {
+        options.accounting = ACCOUNTING_INCREMENTAL;
+    }
+    const char* problem = simulator_check_options(&options);
+    if (problem == NULL && generating) {
+        problem = workload_check_spec(&spec);
+    }
+    if (problem != NULL) {
+        printf("Error: %s\n", problem);
+        return 1;
+    }
+    const WorkloadSpec* generated = generating ? &spec : NULL;
+
+    if (sweep_spec != NULL && streaming) {
+        printf("Error: A sweep cannot stream its input\n");
+        return 1;
+    }
+    if (generating && streaming) {
+        printf("Error: A generated workload cannot be streamed\n");
+        return 1;
+    }
+    if ((show_stats || show_percentiles) && sweep_spec != NULL) {
+        printf("Error: A sweep cannot print statistics\n");
+        return 1;
+    }
+    if ((checkpoint_name != NULL || resume_name != NULL) && (sweep_spec != NULL || streaming)) {
+        printf("Error: Only a single simulation can be checkpointed\n");
+        return 1;
+    }
+    if (sharded && (sweep_spec != NULL || streaming || resume_name != NULL)) {
+        printf("Error: Only a single simulation can be sharded\n");
+        return 1;
+    }
+    if (what_if_name != NULL && (sweep_spec != NULL || streaming || sharded || resume_name != NULL)) {
+        printf("Error: What-if edits apply to a single simulation\n");
+        return 1;
+    }
+    if (sharded && binary_trace_name != NULL) {
+        printf("Error: A sharded run cannot write a binary trace\n");
+        return 1;
+    }
+    if ((checkpoint_name != NULL || resume_name != NULL) && binary_trace_name != NULL) {
+        printf("Error: A checkpointed run cannot write a binary trace\n");
+        return 1;
+    }
+    if (serve_path != NULL && (sweep_spec != NULL || streaming || sharded || generating || what_if_name != NULL ||
+                               checkpoint_name != NULL || resume_name != NULL || binary_trace_name != NULL ||
+                               show_stats || show_percentiles || arg < argc)) {
+        printf("Error: A server takes its workloads and algorithms from its queries\n");
+        return 1;
+    }
+
+    // Answer queries on a socket until interrupted
+    if (serve_path != NULL) {
+        if (num_threads == 0) {
+            long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+            num_threads = cpus > 0 ? (int)cpus : 1;
+        }
+        // The worker pool already spans the CPUs, so each query runs on one thread
+        options.num_threads = 1;
+        return run_server(serve_path, &options, num_threads, cache_size);
+    }
+
+    // Continue an interrupted run where its last checkpoint left off
+    if (resume_name != NULL) {
+        Simulator* sim = simulator_create(&options);
+        if (show_stats && simulator_stats(sim) == NULL) {
+            printf("Error: Statistics require a build with make STATS=1\n");
+            return 1;
+        }
+        if (checkpoint_name != NULL) {
+            simulator_set_checkpoint(sim, checkpoint_name, checkpoint_interval);
+        }
+        Policy policy;
+        problem = simulator_resume(sim, resume_name, &policy);
+        if (problem != NULL) {
+            printf("Error: %s (%s)\n", problem, resume_name);
+            simulator_destroy(sim);
+            return 1;
+        }
+        if (simulator_checkpoints_written(sim) < 0) {
+            fprintf(stderr, "Warning: Could not write checkpoint %s\n", checkpoint_name);
+        }
+        print_final_stats(sim);
+        if (show_percentiles) {
+            print_percentiles(sim);
+        }
+        if (show_stats) {
+            print_stats(simulator_stats(sim));
+        }
+        simulator_destroy(sim);
+        return 0;
+    }
+    if (sweep_spec != NULL) {
+        SweepConfig* configs;
+        int num_configs = parse_sweep(sweep_spec, &configs);
+        if (num_configs < 0) {
+            printf("Error: Invalid sweep specification %s\n", sweep_spec);
+            return 1;
+        }
+        if (binary_trace_name != NULL) {
+            printf("Error: A sweep cannot write a binary trace\n");
+            return 1;
+        }
+        if (num_threads == 0) {
+            long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+            num_threads = cpus > 0 ? (int)cpus : 1;
+        }
+
+        // Load once; every configuration runs silently on its own copy
+        Simulator* workload = simulator_create(&options);
+        if (load_workload(workload, argv[arg], reserve, generated) != 0) {
+            return 1;
+        }
+        for (int i = 0; i < num_configs; i++) {
+            const char* problem = simulator_check_policy(workload, configs[i].policy);
+            if (problem != NULL) {
+                printf("Error: %s\n", problem);
+                return 1;
+            }
+        }
+        run_sweep(workload, &options, configs, num_configs, num_threads);
+        free(configs);
+        simulator_destroy(workload);
+        return 0;
+    }
+
+    const char* algorithm = argv[arg];  // Scheduling algorithm option
+    const char* filename;               // Input file name
+    Policy policy;                      // Scheduling policy selected by the algorithm option
+    int quantum = 0;                    // Time quantum for Round Robin
+
+    // Handle Round Robin specific argument
+    if (strcmp(algorithm, "-f") == 0) {
+        policy = POLICY_FCFS;
+        filename = argv[arg + 1];  // Input file name follows the algorithm
+    } else if (strcmp(algorithm, "-s") == 0) {
+        policy = POLICY_SJF;
+        filename = argv[arg + 1];
+    } else if (strcmp(algorithm, "-r") == 0) {
+        policy = POLICY_RR;
+        if (argc - arg < 2 + inputs) {
+            printf("Error: Round Robin requires a time quantum\n");
+            return 1;
+        }
+        // Parse quantum from command line argument
+        quantum = atoi(argv[arg + 1]);
+        if (quantum <= 0) {
+            printf("Error: Time quantum must be positive\n");
+            return 1;
+        }
+        filename = argv[arg + 2];  // Input file name follows the quantum
+    } else if (strcmp(algorithm, "-m") == 0) {
+        policy = POLICY_MLFQ;      // Levels and quanta come from --mlfq
+        filename = argv[arg + 1];
+    } else if (strcmp(algorithm, "-c") == 0) {
+        policy = POLICY_CFS;       // Period and slices come from --cfs-latency and --min-granularity
+        filename = argv[arg + 1];
+    } else {
+        printf("Error: Invalid algorithm option\n");
+        return 1;
+    }
+
+    // Simulate jobs as they are read, keeping only the live ones
+    if (streaming) {
+        Simulator* sim = simulator_create(&options);
+        problem = simulator_check_stream(sim, policy);
+        if (problem == NULL && show_stats && simulator_stats(sim) == NULL) {
+            problem = "Statistics require a build with make STATS=1";
+        }
+        if (problem != NULL) {
+            printf("Error: %s\n", problem);
+            simulator_destroy(sim);
+            return 1;
+        }
+        if (binary_trace_name != NULL && !binary_trace_open(sim, binary_trace_name)) {
+            printf("Error: Could not create file %s\n", binary_trace_name);
+            simulator_destroy(sim);
+            return 1;
+        }
+        int status = stream_workload(sim, &options, policy, quantum, filename, report_interval);
+        binary_trace_close(sim);
+        if (status == 0 && show_percentiles) {
+            print_percentiles(sim);
+        }
+        if (status == 0 && show_stats) {
+            print_stats(simulator_stats(sim));
+        }
+        simulator_destroy(sim);
+        return status;
+    }
+
+    // Read processes from input file; a sharded run keeps its shards single-threaded
+    if (!sharded) {
+        options.num_threads = num_threads;
+    }
+    Simulator* sim = simulator_create(&options);
+    if (show_stats && simulator_stats(sim) == NULL) {
+        printf("Error: Statistics require a build with make STATS=1\n");
+        return 1;
+    }
+    if (checkpoint_name != NULL) {
+        simulator_set_checkpoint(sim, checkpoint_name, checkpoint_interval);
+    }
+    if (what_if_name != NULL) {
+        simulator_set_snapshots(sim, snapshot_interval);
+    }
+    if (load_workload(sim, filename, reserve, generated) != 0) {
+        return 1;
+    }
+    problem = sharded ? simulator_check_shards(sim, policy) : simulator_check_policy(sim, policy);
+    if (problem != NULL) {
+        printf("Error: %s\n", problem);
+        return 1;
+    }
+
+    // The binary trace records a single timeline
+    if (binary_trace_name != NULL && options.num_cores > 1) {
+        printf("Error: A multi-core run cannot write a binary trace\n");
+        return 1;
+    }
+    if (binary_trace_name != NULL && options.engine == ENGINE_ANALYTIC) {
+        printf("Error: The analytic engine cannot write a binary trace\n");
+        return 1;
+    }
+    if (binary_trace_name != NULL && !binary_trace_open(sim, binary_trace_name)) {
+        printf("Error: Could not create file %s\n", binary_trace_name);
+        return 1;
+    }
+
+    // Run the selected scheduling algorithm, on every partition at once when sharded
+    print_policy_header(&options, policy, quantum);
+    if (sharded) {
+        if (num_threads == 0) {
+            long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+            num_threads = cpus > 0 ? (int)cpus : 1;
+        }
+        int num_shards = run_sharded(sim, policy, quantum, num_threads);
+        printf("%d shard%s on up to %d thread%s\n", num_shards, num_shards == 1 ? "" : "s",
+               num_threads, num_threads == 1 ? "" : "s");
+    } else {
+        run_simulation(sim, policy, quantum);
+    }
+
+    binary_trace_close(sim);
+    if (simulator_checkpoints_written(sim) < 0) {
+        fprintf(stderr, "Warning: Could not write checkpoint %s\n", checkpoint_name);
+    }
+
+    // Print final statistics
+    print_final_stats(sim);
+    if (show_percentiles) {
+        print_percentiles(sim);
+    }
+    if (show_stats) {
+        print_stats(simulator_stats(sim));
+    }
+    int status = what_if_name != NULL ? print_what_ifs(sim, what_if_name) : 0;
+    simulator_destroy(sim);
+    return status;
+}
+
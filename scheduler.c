@@ -1,281 +1,5495 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <stdbool.h>
 #include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <pthread.h>
+// The vector sweep kernels work on eight 32-bit times at once
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(SCHEDULER_TIME64)
+#include <immintrin.h>
+#define HAVE_AVX2_KERNELS 1
+#endif
+#include "scheduler.h"
 
-// Maximum number of processes that can be handled
-#define MAX_PROCESSES 100
-// Maximum length of a line in the input file
-#define MAX_LINE_LENGTH 256
+// Initial capacity of the process table when no size hint is given
+#define INITIAL_PROCESS_CAPACITY 64
+// Initial capacity of the phase table holding I/O and CPU bursts
+#define INITIAL_PHASE_CAPACITY 256
+// Size of the input buffer; longer lines are treated as malformed
+#define READ_BUFFER_SIZE (1 << 20)
+// Size of the output buffer used for traces and per-process statistics
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+// Size of the write buffer of the binary trace
+#define BINARY_TRACE_BUFFER_SIZE (1 << 16)
+// File signature and version of the binary trace
+#define BINARY_TRACE_MAGIC "SSEG"
+#define BINARY_TRACE_VERSION 1
+// Bytes in the binary trace header: magic, version, segment count
+#define BINARY_TRACE_HEADER_SIZE 16
 
-// Structure to hold process information
+// First bytes and format version of a checkpoint file
+#define CHECKPOINT_MAGIC "SCKP"
+#define CHECKPOINT_VERSION 2
+
+// First bytes and format version of a columnar workload file
+#define COLUMNS_MAGIC "SWKC"
+#define COLUMNS_VERSION 1
+// Bytes before the first column: magic, u32 version, u64 count, u32 flags, u32 block size
+#define COLUMNS_HEADER_SIZE 24
+// Columns of a columnar workload: burst, arrival, priority and partition
+#define NUM_COLUMNS 4
+// Flag of a columnar workload whose column data is followed by block checksums
+#define COLUMNS_CHECKSUMMED 1
+// Bytes of column data covered by each checksum of a written file
+#define COLUMNS_BLOCK_SIZE (1 << 20)
+
+// Event loop iterations between readings of the clock for a due checkpoint
+#define CHECKPOINT_POLL_ITERATIONS 4096
+// Fractional bits kept in CFS virtual runtimes
+#define CFS_VRUNTIME_SHIFT 10
+// CFS weight of a process at priority 0
+#define NICE_0_WEIGHT 1024
+
+// Instrumentation hooks, compiled in with -DSCHEDULER_STATS and otherwise
+// expanding to nothing, so the hot paths carry no counters by default
+#ifdef SCHEDULER_STATS
+#define STATS_ADD(sim, counter, amount) ((sim)->stats.counter += (amount))
+#define STATS_READY(sim) ((sim)->stats.max_ready = (sim)->ready_count > (sim)->stats.max_ready ? (sim)->ready_count : (sim)->stats.max_ready)
+#define STATS_RUN(sim, tracker, p) stats_run(&(sim)->stats, (tracker), (p))
+#define STATS_TIMER_START(timer) double timer = monotonic_clock()
+#define STATS_TIMER_STOP(sim, timer, phase) ((sim)->stats.phase += monotonic_clock() - (timer))
+#else
+#define STATS_ADD(sim, counter, amount) ((void)0)
+#define STATS_READY(sim) ((void)0)
+#define STATS_RUN(sim, tracker, p) ((void)0)
+#define STATS_TIMER_START(timer) ((void)0)
+#define STATS_TIMER_STOP(sim, timer, phase) ((void)0)
+#endif
+
+// Inlines the tick engine's loop and helpers into each specialized variant,
+// whose constant arguments then fold away every mode test
+#define TICK_INLINE inline __attribute__((always_inline))
+
+// Times below this are counted exactly by a LatencySketch; above it each
+// power of two is split into half as many buckets
+#define SKETCH_SUB_BUCKETS 128
+
+// Buckets of a LatencySketch: the exact ones, then 64 per power of two up to SIM_TIME_MAX
+#define SKETCH_BUCKETS (SKETCH_SUB_BUCKETS + (8 * (int)sizeof(SimTime) - 1 - 7) * (SKETCH_SUB_BUCKETS / 2))
+
+// Most generated workload time, in multiples of the mean, before a draw is cut off
+#define GENERATED_TIME_CUTOFF 10000.0
+// Fewest processes the analytic engine gives a thread of its own
+#define ANALYTIC_MIN_RANGE (1 << 16)
+
+// Exact sum of times: 64 bits hold 2^31 sums of 32-bit times, 64-bit times need 128
+#ifdef SCHEDULER_TIME64
+typedef __int128 TimeTotal;
+#else
+typedef int64_t TimeTotal;
+#endif
+
+// Result of parsing one line of the input file
+typedef enum {
+    LINE_BLANK,     // Empty line, ignored
+    LINE_PROCESS,   // Valid process description
+    LINE_MALFORMED  // Anything else, skipped and counted
+} LineStatus;
+
+// Accounting mode and layout a variant of the tick engine is compiled for
+typedef enum {
+    TICK_INCREMENTAL,   // Incremental accounting
+    TICK_SCAN_AOS,      // Scan accounting sweeping the process table
+    TICK_SCAN_SOA,      // Scan accounting sweeping the columns
+    NUM_TICK_MODES
+} TickMode;
+
+// Columns of a valid process line
+typedef struct {
+    SimTime burst_time;     // First CPU burst
+    SimTime arrival_time;   // Arrival time, -1 when the column is absent
+    int priority;           // Nice value, 0 when the column is absent
+    int partition;          // Partition after an @ in the ID, 0 when there is none
+    int num_phases;         // Number of I/O and CPU burst pairs after the priority
+    const char* phases;     // First character of the first I/O burst column
+    const char* end;        // Character after the last column
+} ProcessLine;
+
+#ifdef SCHEDULER_STATS
+// Process a processor ran last, for telling context switches and preemptions apart
+typedef struct {
+    int id;         // ID of the process, -1 before the first run
+    bool cut;       // Whether its last run ended with its CPU burst unfinished
+} SwitchTracker;
+#endif
+
+// Draws the processes of a WorkloadSpec from a xoshiro256** generator
+typedef struct {
+    const WorkloadSpec* spec;   // Workload being generated
+    uint64_t state[4];          // Generator state, seeded by SplitMix64
+    double arrival;             // Arrival time of the next process, before rounding down
+} WorkloadGenerator;
+
+// Jobs read incrementally from a file descriptor by run_stream()
+typedef struct {
+    int fd;                 // Descriptor the jobs are read from
+    char* buffer;           // Block of input being parsed
+    size_t start;           // Offset of the first unparsed byte in buffer
+    size_t length;          // Bytes of input in buffer
+    bool at_end;            // Whether the end of the input has been reached
+    bool failed;            // Whether reading the input failed
+    bool discarding;        // Whether the rest of an overlong line is being skipped
+    bool pending;           // Whether the next job has been read but not admitted
+    SimTime burst_time;     // Burst time of the next job
+    SimTime arrival_time;   // Arrival time of the next job
+    int priority;           // Priority of the next job
+    int count;              // Jobs read so far, which numbers their IDs
+    int malformed;          // Lines that could not be parsed
+} StreamReader;
+
+// Run of consecutive time units of one process, waiting to be printed
 typedef struct {
+    bool active;            // Whether a segment is pending
+    SimTime start;          // First time unit of the segment
+    SimTime last;           // Last time unit of the segment
     int id;                 // Process ID
-    int burst_time;         // Total CPU time required
-    int remaining_time;     // Remaining CPU time
-    int arrival_time;       // Arrival time (used for FCFS and SJF)
-    int wait_time;          // Total time the process has waited
-    int turnaround_time;    // Total time from arrival to completion
-    bool completed;         // Flag to indicate if process has completed execution
-} Process;
-
-// Global variables  
-Process processes[MAX_PROCESSES];  // Array to hold all processes
-int num_processes = 0;             // Total number of processes read from input file
+    SimTime remaining_time; // Remaining CPU time at the start of the segment
+    SimTime wait_time;      // Wait time at the start of the segment
+    SimTime turnaround_time; // Turnaround time at the start of the segment
+} TraceSegment;
+
+// Binary trace of run segments being written
+typedef struct {
+    FILE* file;             // Output file, NULL when no binary trace was requested
+    uint64_t count;         // Segments written so far
+    bool pending;           // Whether a segment is being merged
+    SimTime start;          // First time unit of the pending segment
+    SimTime end;            // Time unit after the last one of the pending segment
+    int id;                 // Process ID of the pending segment
+    SimTime previous_end;   // End of the last segment written, for delta encoding
+    int previous_id;        // Process ID of the last segment written, for delta encoding
+    size_t length;          // Bytes used in buffer
+    unsigned char buffer[BINARY_TRACE_BUFFER_SIZE]; // Encoded segments not yet written
+} BinaryTrace;
+
+// Periodic checkpoints of an event-engine run
+typedef struct {
+    char* filename;         // File checkpoints are written to, NULL when disabled
+    double interval;        // Seconds between checkpoints
+    double last_time;       // Clock reading of the last checkpoint or of the start of the run
+    int countdown;          // Event loop iterations until the clock is read again
+    int written;            // Checkpoints written so far, -1 once one could not be written
+    Policy policy;          // Policy of the run being checkpointed
+    int quantum;            // Time quantum of the run being checkpointed
+} Checkpointing;
+
+// Fixed part of a checkpoint file; it is followed by the process table, the
+// phase table, the ready processes, the blocked queue and the latency sketches.
+// Fields are stored as laid out in memory, so a checkpoint is read back by the
+// same build of the simulator
+typedef struct {
+    char magic[4];              // CHECKPOINT_MAGIC
+    uint32_t version;           // CHECKPOINT_VERSION
+    uint32_t process_size;      // sizeof(Process) of the writer
+    int32_t policy;             // Policy of the run
+    int32_t quantum;            // Time quantum of the run
+    int64_t current_time;       // Simulation time at the top of the event loop
+    int32_t preempted;          // Round Robin process to requeue first, -1 if none
+    int32_t num_processes;      // Entries of the process table
+    int32_t num_phase_entries;  // Entries of the phase table
+    int32_t ready_size;         // Ready processes
+    int32_t blocked_size;       // Processes blocked on I/O
+    int32_t next_arrival;       // Index of the first process that had not arrived
+    int32_t ready_count;        // Processes arrived and not completed or blocked
+    int32_t completed_count;    // Processes completed
+    int32_t tracker_id;         // Instrumentation: process run last, -1 if none
+    int32_t tracker_cut;        // Instrumentation: whether it stopped with its burst unfinished
+    int64_t segments;           // Segments run so far
+    TraceSegment pending_segment; // Trace segment being collapsed
+    SimulatorStats stats;       // Instrumentation counters, zero without SCHEDULER_STATS
+} CheckpointHeader;
+
+// Loop state of a run being resumed from a checkpoint, consumed when the loop starts
+typedef struct {
+    const int* ready;       // Ready processes, in queue order or heap order
+    int ready_size;         // Number of ready processes
+    SimTime current_time;   // Simulation time at the top of the loop
+    int preempted;          // Round Robin process whose quantum had just expired, -1 if none
+} ResumeState;
+
+// State of the event loop kept in memory by a run recorded for what-if runs;
+// the ready and blocked processes, and copies of them, are ranges of the pools
+// of the WhatIfLog
+typedef struct {
+    SimTime current_time;   // Simulation time at the top of the event loop
+    int preempted;          // Round Robin process to requeue first, -1 if none
+    int next_arrival;       // Index of the first process that had not arrived
+    int ready_count;        // Processes arrived and not completed or blocked
+    int completed_count;    // Processes completed
+    int64_t segments;       // Segments run so far
+    size_t first_ready;     // Offset of the ready processes in the ready pool
+    int ready_size;         // Ready processes, in queue order or heap order
+    size_t first_blocked;   // Offset of the blocked processes in the blocked pool
+    int blocked_size;       // Processes blocked on I/O, in heap order
+    size_t first_live;      // Offset in the live pool of copies of the ready, blocked and preempted processes
+} Snapshot;
+
+// Log-linear histogram of non-negative times, in constant memory whatever the
+// number of processes: exact below SKETCH_SUB_BUCKETS, to within 1/128 above
+typedef struct {
+    uint64_t counts[SKETCH_BUCKETS];    // Times recorded in each bucket
+    uint64_t total;                     // Times recorded
+    SimTime max;                        // Largest time recorded
+} LatencySketch;
+
+// Formatted text waiting to be written to stdout
+typedef struct {
+    size_t length;                      // Bytes used in data
+    char data[OUTPUT_BUFFER_SIZE];      // Text not yet written
+} OutputBuffer;
+
+// Binary min-heap of process indices ordered by (remaining_time, arrival_time)
+typedef struct {
+    int* items;                 // Indices into the process table
+    int capacity;               // Number of slots in items
+    int size;                   // Number of queued processes
+    const Process* processes;   // Process table the indices refer to
+} ProcessHeap;
+
+// Fixed-capacity FIFO ring buffer of process indices for Round Robin
+typedef struct {
+    int* items;     // Indices into the process table
+    int capacity;   // Number of slots in items
+    int head;       // Slot of the process at the front of the queue
+    int size;       // Number of queued processes
+} RunQueue;
+
+// Process blocked on I/O
+typedef struct {
+    SimTime wake_time; // Time its I/O burst completes
+    int index;      // Index into the process table
+} BlockedProcess;
+
+// Binary min-heap of processes blocked on I/O ordered by (wake_time, index)
+typedef struct {
+    BlockedProcess* items;  // Blocked processes
+    int capacity;           // Number of slots in items
+    int size;               // Number of blocked processes
+} BlockedQueue;
+
+// Node of the CFS red-black tree; node i belongs to process i
+typedef struct {
+    int left;           // Index of the left child, nil if none
+    int right;          // Index of the right child, nil if none
+    int parent;         // Index of the parent, nil at the root
+    bool red;           // Node colour
+    int64_t vruntime;   // Virtual runtime in units of 2^-CFS_VRUNTIME_SHIFT
+} TreeNode;
+
+// Red-black tree of runnable processes ordered by (vruntime, arrival_time, id)
+typedef struct {
+    TreeNode* nodes;            // One node per process plus the sentinel
+    int nil;                    // Index of the black sentinel node
+    int root;                   // Index of the root, nil when empty
+    int leftmost;               // Index of the smallest node, nil when empty
+    int size;                   // Number of processes in the tree
+    const Process* processes;   // Process table the nodes refer to
+} VruntimeTree;
+
+// One core of a multi-core simulation
+typedef struct {
+    int running;            // Index of the process the core is dispatched to, -1 when idle
+    SimTime dispatch_time;  // Time the core was dispatched to the running process
+    SimTime exec_start;     // Time the running process starts executing, after any migration
+    SimTime end;            // Time the running segment ends unless it is preempted
+    SimTime start_remaining; // Remaining time of the running process when it was dispatched
+    int preempted;          // Round Robin process whose quantum just expired, -1 if none
+    ProcessHeap heap;       // SJF ready queue; the running process stays on top
+    RunQueue queue;         // FCFS and Round Robin ready queue
+#ifdef SCHEDULER_STATS
+    SwitchTracker tracker;  // Process the core ran last
+#endif
+} Core;
+
+// Column copy of the fields touched by the per-tick sweeps
+typedef struct {
+    SimTime* remaining_time; // Remaining CPU time of each process
+    SimTime* arrival_time;  // Arrival time of each process
+    SimTime* wait_time;     // Wait time accumulated by the sweeps
+    SimTime* turnaround_time; // Turnaround time accumulated by the sweeps
+    uint64_t* completed;    // Packed completion bitset, one bit per process
+} ProcessColumns;
+
+// Column data being written to a columnar workload file, with its checksums
+typedef struct {
+    FILE* file;             // Destination
+    unsigned char buffer[1 << 16]; // Data not yet written, a multiple of 8 bytes when flushed
+    size_t used;            // Bytes held in buffer
+    uint64_t checksum;      // Checksum of the current block so far
+    size_t block_used;      // Bytes of the current block so far
+    uint64_t* checksums;    // Checksums of the completed blocks
+    size_t num_checksums;   // Number of completed blocks
+} ColumnWriter;
+
+// Range of the process table run by one thread of the analytic engine
+typedef struct {
+    Simulator* sim;         // Simulator being run
+    int first;              // Index of the first process of the range
+    int end;                // Index after the last process of the range
+    int64_t shift;          // The range completes at max(c + shift, floor) when the process
+    int64_t floor;          // before it completes at c
+    int64_t previous;       // Completion time of the process before the range
+    LatencySketch sketches[NUM_METRICS]; // Distribution of each metric over the range
+} AnalyticRange;
+
+// Sweep kernels over the columns, selected from the CPU's features
+typedef struct {
+    const char* name;                                               // Instruction set used by the kernels
+    Process* (*next_sjf)(Simulator* sim, SimTime current_time);     // get_next_sjf_process() equivalent
+    void (*update_wait)(Simulator* sim, SimTime current_time, int active); // update_wait_times() equivalent
+    void (*update_turnaround)(Simulator* sim, SimTime current_time); // update_turnaround_times() equivalent
+} SweepKernels;
+
+// Processes of one partition, simulated by run_sharded() as an independent single-core run
+typedef struct {
+    int first;      // Position of its first process in ShardPool.order
+    int count;      // Number of processes
+} Shard;
+
+// Shards dealt to one worker of a sharded run, from which idle workers steal
+typedef struct {
+    pthread_mutex_t lock;   // Guards the other fields
+    int* shards;            // Indices into ShardPool.shards, largest first
+    int head;               // Position of the next shard to take
+    int tail;               // Position after the last shard
+    int64_t queued;         // Processes in the shards not taken yet
+} ShardDeque;
+
+// Work shared by the workers of a sharded run
+typedef struct {
+    Simulator* sim;         // Simulator holding the whole process table
+    Policy policy;          // Scheduling policy of every shard
+    int quantum;            // Time quantum for Round Robin
+    const int* order;       // Process table indices grouped by partition, in table order within each
+    const Shard* shards;    // Partitions of the table
+    ShardDeque* deques;     // One deque per worker
+    int num_workers;        // Number of workers
+} ShardPool;
+
+// One worker thread of a sharded run and the results it has merged so far
+typedef struct {
+    ShardPool* pool;                        // Work shared with the other workers
+    int index;                              // Index of the worker and of its deque
+    LatencySketch sketches[NUM_METRICS];    // Sketches of the shards it ran
+    int64_t segments;                       // Segments of the shards it ran
+    int steals;                             // Shards it took from other deques
+#ifdef SCHEDULER_STATS
+    SimulatorStats stats;                   // Counters of the shards it ran
+#endif
+} ShardWorker;
+
+// Recorded run and the state of the what-if run re-simulating part of it
+typedef struct {
+    int interval;               // Fewest event loop iterations between snapshots, 0 when not recording
+    bool recording;             // Whether the running loop takes snapshots
+    int countdown;              // Event loop iterations until the next snapshot
+    bool recorded;              // Whether the process table holds the results of a recorded run
+    Policy policy;              // Policy of the recorded run
+    int quantum;                // Time quantum of the recorded run
+    Snapshot* snapshots;        // Snapshots in order of simulation time
+    int num_snapshots;          // Snapshots taken
+    int snapshot_capacity;      // Snapshots that fit without growing
+    int* ready;                 // Pool of ready processes
+    size_t ready_used;          // Entries used in ready
+    size_t ready_capacity;      // Entries ready can hold without growing
+    BlockedProcess* blocked;    // Pool of blocked processes
+    size_t blocked_used;        // Entries used in blocked
+    size_t blocked_capacity;    // Entries blocked can hold without growing
+    Process* live;              // Pool of copies of the processes that were ready, blocked or preempted
+    size_t live_used;           // Entries used in live
+    size_t live_capacity;       // Entries live can hold without growing
+    int* index_of_id;           // Table index of each process ID after the recorded run
+    TimeTotal total_wait_time;  // Sum of the wait times of the recorded run
+    TimeTotal total_turnaround_time; // Sum of the turnaround times of the recorded run
+    SimTime makespan;           // Completion time of the last process of the recorded run
+    int64_t segments;           // Segments of the recorded run
+    bool replaying;             // Whether the running loop is a what-if run
+    int edited;                 // Index of the process whose burst the what-if run changes
+    SimTime edited_burst;       // First CPU burst the edited process is given
+    int prepared;               // Index of the first process not yet reset for the what-if run
+    int next_snapshot;          // First snapshot the what-if run has not passed
+    bool converged;             // Whether the what-if run reached the state of a snapshot
+    int* journal;               // Processes the what-if run changes
+    Process* saved;             // Recorded state of each process in journal
+    int journal_size;           // Entries used in journal and saved
+    int journal_capacity;       // Entries journal and saved can hold without growing
+    LatencySketch sketches[NUM_METRICS]; // Sketches of the recorded run, kept during a what-if run
+} WhatIfLog;
+
+// Process table and the state of the running simulation
+struct Simulator {
+    Process* processes;             // Array to hold all processes, grown in bulk
+    int num_processes;              // Total number of processes read from input file
+    int process_capacity;           // Number of processes the table can hold without growing
+    SimTime* phases;                // I/O and CPU bursts that follow the first CPU burst of each process
+    int num_phase_entries;          // Entries used in phases
+    int phase_capacity;             // Entries phases can hold without growing
+    Engine engine;                  // Simulation engine
+    int num_cores;                  // Number of simulated cores
+    bool work_stealing;             // Whether idle cores steal queued processes
+    int migration_cost;             // Delay before a stolen process executes
+    CoreStats* core_stats;          // Per-core results of the last multi-core run
+    int mlfq_levels;                // Number of MLFQ priority levels
+    int mlfq_quanta[MLFQ_MAX_LEVELS]; // Time slice of each MLFQ level
+    int mlfq_boost_period;          // Time units between MLFQ priority boosts, 0 for none
+    int cfs_latency;                // CFS scheduling period for few runnable processes
+    int cfs_min_granularity;        // Shortest CFS slice
+    int num_threads;                // Threads of the analytic engine, 0 for one per online CPU
+    Accounting accounting;          // How wait and turnaround times are maintained
+    Layout layout;                  // Layout swept by scan accounting
+    TraceLevel trace_level;         // Amount of output to produce
+    int ready_count;                // Processes that have arrived but not completed
+    int completed_count;            // Processes that have completed
+    int next_arrival;               // Index of the first process that has not arrived yet
+    int64_t segments;               // Segments run by the event engine so far
+    BlockedQueue blocked;           // Processes waiting for an I/O burst to complete
+    ProcessColumns columns;         // Sweep columns when the layout is LAYOUT_SOA
+    const SweepKernels* kernels;    // Column sweep kernels, set by select_sweep_kernels()
+    TraceSegment pending_segment;   // Segment being collapsed for TRACE_SEGMENTS
+    OutputBuffer output;            // Formatted output not yet written to stdout
+    BinaryTrace binary_trace;       // Binary segment trace, if requested
+    LatencySketch sketches[NUM_METRICS]; // Distribution of each metric over the completed processes
+    Checkpointing checkpoint;       // Periodic checkpoints, if requested
+    const ResumeState* resume;      // Loop state of a run being resumed, NULL otherwise
+    WhatIfLog what_if;              // Snapshots of the last run for run_what_if(), if requested
+    bool polled;                    // Whether the event loops call event_loop_poll()
+#ifdef SCHEDULER_STATS
+    SimulatorStats stats;           // Instrumentation counters
+    SwitchTracker tracker;          // Process the single core ran last
+#endif
+};
+
+// Function prototypes
+static bool load_process_line(Simulator* sim, const char* line, const char* end);
+static int map_columns(Simulator* sim, int fd);
+static int load_columns_data(Simulator* sim, const unsigned char* data, size_t size);
+static int32_t column_value(const unsigned char* column, size_t index);
+static uint64_t checksum_update(uint64_t checksum, const unsigned char* data, size_t length);
+static void store_le(unsigned char* buffer, uint64_t value, int bytes);
+static uint64_t load_le(const unsigned char* buffer, int bytes);
+static void column_write(ColumnWriter* writer, int32_t value);
+static void column_flush(ColumnWriter* writer);
+static LineStatus parse_process_line(const char* line, const char* end, ProcessLine* fields);
+static const char* parse_column(const char* c, const char* end, bool allow_negative, SimTime* value);
+static int compare_arrivals(const void* a, const void* b);
+static void init_process(Process* p, int id);
+static void reset_process(Simulator* sim, Process* p);
+static bool stream_peek(StreamReader* reader);
+static void stream_take_line(StreamReader* reader, const char* line, const char* end);
+static int stream_admit(Simulator* sim, StreamReader* reader, RunQueue* free_slots);
+static void stream_report(Simulator* sim, SimTime current_time, int64_t completed, int live, TimeTotal total_wait_time, TimeTotal total_turnaround_time);
+static void free_processes(Simulator* sim);
+static void sort_by_arrival(Simulator* sim);
+static int compare_partitions(const void* a, const void* b);
+static int compare_shard_sizes(const void* a, const void* b);
+static void* shard_worker(void* arg);
+static int shard_take(ShardPool* pool, int worker, bool* stolen);
+static Simulator* shard_simulator_create(const Simulator* sim);
+static void shard_load(Simulator* shard, const Simulator* sim, const int* indices, int count);
+static int sketch_bucket(SimTime value);
+static SimTime sketch_value(int bucket);
+static void sketch_add(LatencySketch* sketch, SimTime value);
+static void sketch_merge(LatencySketch* sketch, const LatencySketch* other);
+static double monotonic_clock(void);
+#ifdef SCHEDULER_STATS
+static void stats_run(SimulatorStats* stats, SwitchTracker* tracker, const Process* p);
+static void stats_merge(SimulatorStats* stats, const SimulatorStats* other);
+#endif
+static void generator_init(WorkloadGenerator* generator, const WorkloadSpec* spec);
+static uint64_t generator_random(WorkloadGenerator* generator);
+static double generator_draw(WorkloadGenerator* generator, Distribution distribution, double mean);
+static void generator_next(WorkloadGenerator* generator, SimTime* burst_time, SimTime* arrival_time);
+static void tick_loop(Simulator* sim, Policy policy, TickMode mode, bool traced, int quantum);
+static void simulate_ticks(Simulator* sim, Policy policy, int quantum);
+static bool all_processes_complete(Simulator* sim, TickMode mode);
+static Process* get_next_sjf_process(Simulator* sim, SimTime current_time);
+static void update_wait_times(Simulator* sim, SimTime current_time, int active_process_id);
+static void update_turnaround_times(Simulator* sim, SimTime current_time);
+static void simulate_fcfs_events(Simulator* sim);
+static void simulate_fcfs_analytic(Simulator* sim);
+static void* analytic_compose(void* arg);
+static void* analytic_fill(void* arg);
+static void analytic_run(AnalyticRange* ranges, int num_ranges, void* (*pass)(void* arg));
+static void simulate_sjf_events(Simulator* sim);
+static void simulate_round_robin_events(Simulator* sim, int quantum);
+static void simulate_mlfq_events(Simulator* sim);
+static void simulate_cfs_events(Simulator* sim);
+static void simulate_multicore(Simulator* sim, Policy policy, int quantum);
+static int core_waiting(const Core* core, Policy policy);
+static void core_enqueue(Core* core, Policy policy, int index);
+static int core_steal(Core* core, Policy policy);
+static void core_sync(Simulator* sim, const Core* core, SimTime current_time);
+static void core_stop(Simulator* sim, int c, Core* core, SimTime current_time);
+static void core_dispatch(Simulator* sim, int c, Core* core, int index, SimTime current_time, int delay, int quantum);
+static void run_segment(Simulator* sim, Process* p, SimTime start, SimTime end);
+static void complete_process(Simulator* sim, Process* p, SimTime completion_time);
+static bool end_burst(Simulator* sim, Process* p, SimTime end_time);
+static int wake_process(Simulator* sim, SimTime current_time);
+static SimTime next_ready_time(const Simulator* sim);
+static int least_loaded_core(const Simulator* sim, const Core* cores, Policy policy);
+static int priority_weight(int priority);
+static void reset_accounting(Simulator* sim);
+static void begin_event_run(Simulator* sim, SimTime* current_time, int* preempted, RunQueue* queue, ProcessHeap* heap);
+static void checkpoint_poll(Simulator* sim, SimTime current_time, int preempted, const RunQueue* queue, const ProcessHeap* heap);
+static bool write_checkpoint(Simulator* sim, SimTime current_time, int preempted, const RunQueue* queue, const ProcessHeap* heap);
+static const char* load_checkpoint(Simulator* sim, const unsigned char* data, size_t size, ResumeState* resume);
+static void finish_accounting(Simulator* sim);
+static bool event_loop_poll(Simulator* sim, SimTime current_time, int preempted, const RunQueue* queue, const ProcessHeap* heap);
+static void record_snapshot(Simulator* sim, SimTime current_time, int preempted, const RunQueue* queue, const ProcessHeap* heap);
+static void finish_recording(Simulator* sim);
+static int what_if_fcfs(Simulator* sim, int edited, SimTime burst_time, RunSummary* summary);
+static bool what_if_poll(Simulator* sim, SimTime current_time, int preempted, const RunQueue* queue, const ProcessHeap* heap);
+static bool snapshot_matches(const Simulator* sim, const Snapshot* snapshot, int preempted, const RunQueue* queue, const ProcessHeap* heap);
+static bool same_progress(const Process* a, const Process* b);
+static void journal_process(Simulator* sim, int index);
+static void* reserve_items(void* items, size_t* capacity, size_t needed, size_t size);
+static void execute_time_unit(Simulator* sim, TickMode mode, Process* p, SimTime current_time);
+static void load_columns(Simulator* sim);
+static void free_columns(Simulator* sim);
+static Process* get_next_sjf_process_columns(Simulator* sim, SimTime current_time);
+static void update_wait_times_columns(Simulator* sim, SimTime current_time, int active_process_id);
+static void update_turnaround_times_columns(Simulator* sim, SimTime current_time);
+static void select_sweep_kernels(Simulator* sim, bool allow_simd);
+#ifdef HAVE_AVX2_KERNELS
+static Process* get_next_sjf_process_avx2(Simulator* sim, SimTime current_time);
+static void update_wait_times_avx2(Simulator* sim, SimTime current_time, int active_process_id);
+static void update_turnaround_times_avx2(Simulator* sim, SimTime current_time);
+#endif
+static void admit_arrivals(Simulator* sim, SimTime current_time);
+static void update_times(Simulator* sim, TickMode mode, SimTime current_time, int active_process_id);
+static void print_tick(Simulator* sim, TickMode mode, SimTime current_time, const Process* p);
+static bool trace_enabled(Simulator* sim);
+static bool horizon_fits(const Simulator* sim);
+static void trace_line(Simulator* sim, SimTime current_time, int id, SimTime remaining_time, SimTime wait_time, SimTime turnaround_time);
+static void trace_segment(Simulator* sim, SimTime start, SimTime end, int id, SimTime remaining_time, SimTime wait_time, SimTime turnaround_time);
+static void print_pending_segment(Simulator* sim);
+static void trace_finish(Simulator* sim);
+static void binary_trace_segment(Simulator* sim, SimTime start, SimTime end, int id);
+static void binary_trace_write_pending(Simulator* sim);
+static void binary_trace_flush(Simulator* sim);
+static void output_flush(OutputBuffer* out);
+static void output_text(OutputBuffer* out, const char* text);
+static void output_int(OutputBuffer* out, int64_t value, int width);
+static bool sjf_before(const Process* a, const Process* b);
+static void heap_init(ProcessHeap* heap, int capacity, const Process* processes);
+static void heap_free(ProcessHeap* heap);
+static void heap_push(ProcessHeap* heap, int index);
+static int heap_pop(ProcessHeap* heap);
+static void queue_init(RunQueue* queue, int capacity);
+static void queue_free(RunQueue* queue);
+static void queue_push(RunQueue* queue, int index);
+static int queue_pop(RunQueue* queue);
+static void queue_grow(RunQueue* queue);
+static void heap_grow(ProcessHeap* heap);
+static bool blocked_before(const BlockedProcess* a, const BlockedProcess* b);
+static void blocked_push(BlockedQueue* queue, SimTime wake_time, int index);
+static int blocked_pop(BlockedQueue* queue);
+static bool tree_before(const VruntimeTree* tree, int a, int b);
+static void tree_init(VruntimeTree* tree, int capacity, const Process* processes);
+static void tree_free(VruntimeTree* tree);
+static void tree_rotate_left(VruntimeTree* tree, int x);
+static void tree_rotate_right(VruntimeTree* tree, int x);
+static void tree_insert(VruntimeTree* tree, int index);
+static void tree_transplant(VruntimeTree* tree, int u, int v);
+static void tree_remove(VruntimeTree* tree, int index);
+
+/**
+ * Fills in the options the command line uses when none are given:
+ * the event engine with incremental accounting, printing a full trace
+ * @param options Options to initialize
+ */
+void simulator_default_options(SimulatorOptions* options) {
+    options->engine = ENGINE_EVENT;
+    options->accounting = ACCOUNTING_INCREMENTAL;
+    options->layout = LAYOUT_AOS;
+    options->allow_simd = true;
+    options->trace_level = TRACE_FULL;
+    options->num_cores = 1;
+    options->work_stealing = false;
+    options->migration_cost = 0;
+    options->mlfq_levels = 3;
+    options->mlfq_quanta[0] = 2;
+    options->mlfq_quanta[1] = 4;
+    options->mlfq_quanta[2] = 8;
+    options->mlfq_boost_period = 0;
+    options->cfs_latency = 24;
+    options->cfs_min_granularity = 3;
+    options->num_threads = 1;
+}
+
+/**
+ * Checks that a combination of options can be simulated
+ * @param options Options to check
+ * @return Description of the problem, or NULL if the options are valid
+ */
+const char* simulator_check_options(const SimulatorOptions* options) {
+    // The event engine always derives times from timestamps
+    if (options->accounting == ACCOUNTING_SCAN && options->engine != ENGINE_TICK) {
+        return "Scan accounting requires the tick engine";
+    }
+    // Only scan accounting sweeps the process table
+    if (options->layout == LAYOUT_SOA && options->accounting != ACCOUNTING_SCAN) {
+        return "The SoA layout requires scan accounting";
+    }
+    if (options->num_cores < 1) {
+        return "The core count must be positive";
+    }
+    if (options->migration_cost < 0) {
+        return "The migration cost cannot be negative";
+    }
+    // Cores are only modelled by the event engine
+    if (options->num_cores > 1 && options->engine != ENGINE_EVENT) {
+        return "Multiple cores require the event engine";
+    }
+    if (options->mlfq_levels < 1 || options->mlfq_levels > MLFQ_MAX_LEVELS) {
+        return "The MLFQ needs between 1 and 64 levels";
+    }
+    for (int l = 0; l < options->mlfq_levels; l++) {
+        if (options->mlfq_quanta[l] <= 0) {
+            return "MLFQ quanta must be positive";
+        }
+    }
+    if (options->mlfq_boost_period < 0) {
+        return "The MLFQ boost period cannot be negative";
+    }
+    if (options->cfs_latency <= 0 || options->cfs_min_granularity <= 0) {
+        return "The CFS latency and minimum granularity must be positive";
+    }
+    if (options->num_threads < 0) {
+        return "The thread count cannot be negative";
+    }
+    return NULL;
+}
+
+/**
+ * Creates a simulator with an empty process table
+ * @param options Valid options, see simulator_check_options()
+ * @return New simulator, to be released with simulator_destroy()
+ */
+Simulator* simulator_create(const SimulatorOptions* options) {
+    Simulator* sim = calloc(1, sizeof(Simulator));
+    if (!sim) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    sim->engine = options->engine;
+    sim->num_cores = options->num_cores;
+    sim->work_stealing = options->work_stealing;
+    sim->migration_cost = options->migration_cost;
+    sim->mlfq_levels = options->mlfq_levels;
+    memcpy(sim->mlfq_quanta, options->mlfq_quanta, sizeof(sim->mlfq_quanta));
+    sim->mlfq_boost_period = options->mlfq_boost_period;
+    sim->cfs_latency = options->cfs_latency;
+    sim->cfs_min_granularity = options->cfs_min_granularity;
+    sim->num_threads = options->num_threads;
+    sim->core_stats = calloc(sim->num_cores, sizeof(CoreStats));
+    if (!sim->core_stats) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    sim->accounting = options->accounting;
+    sim->layout = options->layout;
+    sim->trace_level = options->trace_level;
+    if (sim->layout == LAYOUT_SOA) {
+        select_sweep_kernels(sim, options->allow_simd);
+    }
+    return sim;
+}
+
+/**
+ * Releases a simulator and its process table
+ * An open binary trace is completed first
+ * @param sim Simulator to release, may be NULL
+ */
+void simulator_destroy(Simulator* sim) {
+    if (!sim) {
+        return;
+    }
+    binary_trace_close(sim);
+    free_processes(sim);
+    free(sim->blocked.items);
+    free(sim->checkpoint.filename);
+    free(sim->what_if.snapshots);
+    free(sim->what_if.ready);
+    free(sim->what_if.blocked);
+    free(sim->what_if.live);
+    free(sim->what_if.index_of_id);
+    free(sim->what_if.journal);
+    free(sim->what_if.saved);
+    free(sim->core_stats);
+    free(sim);
+}
+
+/**
+ * Reads process information from input file and initializes process array
+ * File format: P<id>[@<partition>],<burst>[,<arrival>[,<priority>[,<io>,<burst>]...]], for
+ * example P0,3 (Process 0 with burst time 3) or P1,4,2,-5,10,6 (Process 1
+ * arriving at time 2 with nice value -5, running for 4, blocking on I/O for
+ * 10, then running for 6 more)
+ * The file is read in large blocks and parsed in place, without stdio line
+ * handling or format strings. A columnar workload written by
+ * write_workload_columns() is recognized by its magic and mapped instead
+ * @param filename Name of the input CSV or columnar file
+ * @return Number of malformed lines or rows that were skipped, or -1 if the
+ *         file cannot be opened or read, or is a damaged columnar file
+ */
+int read_input_file(Simulator* sim, const char* filename) {
+    // Open the file for reading
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        return -1;
+    }
+    STATS_TIMER_START(load_start);
+
+    char* buffer = malloc(READ_BUFFER_SIZE);
+    if (!buffer) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+
+    int malformed = 0;          // Lines that could not be parsed
+    size_t carried = 0;         // Bytes of an incomplete line kept at the start of the buffer
+    bool discarding = false;    // Whether the rest of an overlong line is being skipped
+    bool at_end = false;
+    bool first = true;          // Whether the first block is being parsed
+
+    while (!at_end) {
+        size_t wanted = READ_BUFFER_SIZE - carried;
+        size_t got = fread(buffer + carried, 1, wanted, file);
+        at_end = got < wanted;
+
+        // A columnar workload is mapped instead of parsed
+        if (first && got >= 4 && memcmp(buffer, COLUMNS_MAGIC, 4) == 0) {
+            free(buffer);
+            malformed = map_columns(sim, fileno(file));
+            fclose(file);
+            STATS_TIMER_STOP(sim, load_start, load_seconds);
+            return malformed;
+        }
+        first = false;
+        const char* line = buffer;
+        const char* limit = buffer + carried + got;
+
+        // Parse every complete line in the buffer
+        const char* newline;
+        while ((newline = memchr(line, '\n', limit - line)) != NULL) {
+            if (discarding) {
+                discarding = false;
+            } else if (!load_process_line(sim, line, newline)) {
+                malformed++;
+            }
+            line = newline + 1;
+        }
+
+        // Keep the incomplete last line for the next block
+        carried = limit - line;
+        if (carried == READ_BUFFER_SIZE) {
+            if (!discarding) {
+                malformed++;
+                discarding = true;
+            }
+            carried = 0;
+        } else if (at_end && carried > 0 && !discarding) {
+            // The last line has no trailing newline
+            if (!load_process_line(sim, line, limit)) {
+                malformed++;
+            }
+        } else {
+            memmove(buffer, line, carried);
+        }
+    }
+
+    free(buffer);
+    if (ferror(file)) {
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+    STATS_TIMER_STOP(sim, load_start, load_seconds);
+    return malformed;
+}
+
+/**
+ * Reads process information held in memory, in the format of the input file
+ * Lines are treated exactly as read_input_file() treats them, including
+ * counting lines too long for its buffer as malformed, and columnar
+ * workloads are recognized the same way
+ * @param data Contents of an input file
+ * @param length Number of bytes in data
+ * @return Number of malformed lines or rows that were skipped, or -1 for a
+ *         damaged columnar workload
+ */
+int read_input_data(Simulator* sim, const char* data, size_t length) {
+    STATS_TIMER_START(load_start);
+    if (length >= 4 && memcmp(data, COLUMNS_MAGIC, 4) == 0) {
+        int malformed = load_columns_data(sim, (const unsigned char*)data, length);
+        STATS_TIMER_STOP(sim, load_start, load_seconds);
+        return malformed;
+    }
+    int malformed = 0;
+    const char* line = data;
+    const char* limit = data + length;
+
+    while (line < limit) {
+        const char* newline = memchr(line, '\n', limit - line);
+        const char* end = newline != NULL ? newline : limit;
+        if (end - line >= READ_BUFFER_SIZE || !load_process_line(sim, line, end)) {
+            malformed++;
+        }
+        line = end + 1;
+    }
+    STATS_TIMER_STOP(sim, load_start, load_seconds);
+    return malformed;
+}
+
+/**
+ * Loads a columnar workload from an open file by mapping it
+ * @param fd Descriptor of the file
+ * @return Number of rows that were skipped, or -1 if the file cannot be
+ *         mapped or is damaged
+ */
+static int map_columns(Simulator* sim, int fd) {
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        return -1;
+    }
+    const unsigned char* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+    // The columns are read front to back once
+    madvise((void*)data, (size_t)info.st_size, MADV_SEQUENTIAL);
+    int malformed = load_columns_data(sim, data, (size_t)info.st_size);
+    munmap((void*)data, (size_t)info.st_size);
+    return malformed;
+}
+
+/**
+ * Appends the processes of a columnar workload to the process table
+ * Layout, all little-endian: "SWKC", u32 version, u64 process count, u32
+ * flags, u32 block size, then the burst, arrival, priority and partition
+ * columns as int32 arrays, each padded to a multiple of 8 bytes. With
+ * COLUMNS_CHECKSUMMED the column data is followed by one u64 checksum of
+ * each block of that many bytes, the last one possibly shorter. Rows are
+ * validated as the input file's lines are, and skipped if invalid
+ * @param data Contents of the file
+ * @param size Number of bytes in data
+ * @return Number of rows that were skipped, or -1 if the file is damaged
+ */
+static int load_columns_data(Simulator* sim, const unsigned char* data, size_t size) {
+    if (size < COLUMNS_HEADER_SIZE || memcmp(data, COLUMNS_MAGIC, 4) != 0 ||
+        load_le(data + 4, 4) != COLUMNS_VERSION) {
+        return -1;
+    }
+    uint64_t count = load_le(data + 8, 8);
+    uint32_t flags = (uint32_t)load_le(data + 16, 4);
+    uint64_t block_size = load_le(data + 20, 4);
+    if (count > (uint64_t)INT_MAX - (uint64_t)sim->num_processes) {
+        return -1;
+    }
+    size_t column_size = ((size_t)count * 4 + 7) / 8 * 8;
+    size_t data_size = NUM_COLUMNS * column_size;
+    if (size - COLUMNS_HEADER_SIZE < data_size) {
+        return -1;
+    }
+    const unsigned char* columns = data + COLUMNS_HEADER_SIZE;
+
+    // Check every block against its checksum before trusting the columns
+    if (flags & COLUMNS_CHECKSUMMED) {
+        if (block_size == 0 || block_size % 8 != 0) {
+            return -1;
+        }
+        size_t num_blocks = (data_size + block_size - 1) / block_size;
+        if ((size - COLUMNS_HEADER_SIZE - data_size) / 8 < num_blocks) {
+            return -1;
+        }
+        const unsigned char* checksums = columns + data_size;
+        for (size_t b = 0; b < num_blocks; b++) {
+            size_t offset = b * block_size;
+            size_t length = data_size - offset < block_size ? data_size - offset : block_size;
+            if (checksum_update(0, columns + offset, length) != load_le(checksums + 8 * b, 8)) {
+                return -1;
+            }
+        }
+    }
+
+    reserve_processes(sim, sim->num_processes + (int)count);
+    const unsigned char* bursts = columns;
+    const unsigned char* arrivals = columns + column_size;
+    const unsigned char* priorities = columns + 2 * column_size;
+    const unsigned char* partitions = columns + 3 * column_size;
+    int malformed = 0;
+    for (size_t i = 0; i < count; i++) {
+        int32_t burst_time = column_value(bursts, i);
+        int32_t arrival_time = column_value(arrivals, i);
+        int32_t priority = column_value(priorities, i);
+        int32_t partition = column_value(partitions, i);
+        if (burst_time <= 0 || arrival_time < 0 || priority < PRIORITY_HIGHEST || priority > PRIORITY_LOWEST ||
+            partition < 0) {
+            malformed++;
+            continue;
+        }
+        Process* p = add_process(sim);
+        p->burst_time = burst_time;
+        p->remaining_time = burst_time;
+        p->arrival_time = arrival_time;
+        p->priority = priority;
+        p->partition = partition;
+    }
+    return malformed;
+}
+
+/**
+ * Reads one value of a column of a columnar workload
+ * @param column First byte of the column
+ * @param index Row to read
+ * @return The value stored
+ */
+static int32_t column_value(const unsigned char* column, size_t index) {
+    uint32_t value;
+    memcpy(&value, column + 4 * index, 4);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    return (int32_t)value;
+}
+
+/**
+ * Continues the checksum of a block of a columnar workload, FNV-1a over
+ * little-endian 64-bit words
+ * @param checksum Checksum of the block so far, 0 at its start
+ * @param data Next bytes of the block, a multiple of 8
+ * @param length Number of bytes in data
+ * @return Checksum of the block up to the end of data
+ */
+static uint64_t checksum_update(uint64_t checksum, const unsigned char* data, size_t length) {
+    if (checksum == 0) {
+        checksum = UINT64_C(14695981039346656037);
+    }
+    for (size_t i = 0; i < length; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        checksum = (checksum ^ word) * UINT64_C(1099511628211);
+    }
+    return checksum;
+}
+
+/**
+ * Adds the process described by one line of the input file
+ * @param line First character of the line
+ * @param end Character after the last one of the line
+ * @return false if the line is malformed
+ */
+static bool load_process_line(Simulator* sim, const char* line, const char* end) {
+    ProcessLine fields;
+    LineStatus status = parse_process_line(line, end, &fields);
+
+    if (status == LINE_PROCESS) {
+        // Initialize the process structure
+        Process* p = add_process(sim);
+        p->burst_time = fields.burst_time;
+        p->remaining_time = fields.burst_time;
+        // Without an arrival column, process n arrives at time n
+        p->arrival_time = fields.arrival_time >= 0 ? fields.arrival_time : p->id;
+        p->priority = fields.priority;
+        p->partition = fields.partition;
+
+        // The line was validated, so the burst columns parse cleanly
+        const char* c = fields.phases;
+        for (int k = 0; k < fields.num_phases; k++) {
+            SimTime io_time;
+            SimTime cpu_time;
+            c = parse_column(k > 0 ? c + 1 : c, fields.end, false, &io_time);
+            c = parse_column(c + 1, fields.end, false, &cpu_time);
+            add_io_burst(sim, p, io_time, cpu_time);
+        }
+    }
+    return status != LINE_MALFORMED;
+}
+
+/**
+ * Parses one line of the input file
+ * Accepts P<id>,<burst_time> with a positive burst time, optionally followed
+ * by a non-negative arrival time, a priority between PRIORITY_HIGHEST and
+ * PRIORITY_LOWEST, and pairs of positive I/O and CPU burst times; the ID may
+ * be any text without a comma or an @, optionally followed by an @ and a
+ * non-negative partition number, and trailing whitespace is ignored
+ * @param line First character of the line
+ * @param end Character after the last one of the line (the newline, if any)
+ * @param fields Receives the columns of a valid line
+ * @return Whether the line is blank, a process, or malformed
+ */
+static LineStatus parse_process_line(const char* line, const char* end, ProcessLine* fields) {
+    // Ignore trailing whitespace, including the \r of CRLF files
+    while (end > line && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) {
+        end--;
+    }
+    if (line == end) {
+        return LINE_BLANK;
+    }
+
+    // Process ID: 'P' followed by at least one character before the comma or the @
+    const char* c = line;
+    if (*c++ != 'P' || c == end || *c == ',' || *c == '@') {
+        return LINE_MALFORMED;
+    }
+    while (c < end && *c != ',' && *c != '@') {
+        c++;
+    }
+    fields->partition = 0;
+    if (c < end && *c == '@') {
+        SimTime partition;
+        c = parse_column(c + 1, end, false, &partition);
+        if (c == NULL || partition > INT_MAX) {
+            return LINE_MALFORMED;
+        }
+        fields->partition = (int)partition;
+    }
+    if (c == end) {
+        return LINE_MALFORMED;
+    }
+    c++;
+
+    // Burst time: a positive decimal integer that fits in a SimTime
+    c = parse_column(c, end, false, &fields->burst_time);
+    if (c == NULL || fields->burst_time == 0) {
+        return LINE_MALFORMED;
+    }
+    fields->arrival_time = -1;
+    fields->priority = 0;
+    fields->num_phases = 0;
+    fields->phases = end;
+    fields->end = end;
+
+    if (c < end) {
+        c = parse_column(c + 1, end, false, &fields->arrival_time);
+        if (c == NULL) {
+            return LINE_MALFORMED;
+        }
+    }
+    if (c < end) {
+        SimTime priority;
+        c = parse_column(c + 1, end, true, &priority);
+        if (c == NULL || priority < PRIORITY_HIGHEST || priority > PRIORITY_LOWEST) {
+            return LINE_MALFORMED;
+        }
+        fields->priority = (int)priority;
+    }
+
+    // I/O and CPU bursts alternate, so the line always ends with a CPU burst
+    SimTime total_cpu = fields->burst_time;     // CPU time over all bursts
+    SimTime total_io = 0;                       // I/O time over all bursts
+    if (c < end) {
+        fields->phases = c + 1;
+    }
+    while (c < end) {
+        SimTime io_time;
+        SimTime cpu_time;
+        c = parse_column(c + 1, end, false, &io_time);
+        if (c == NULL || c == end || io_time == 0) {
+            return LINE_MALFORMED;
+        }
+        c = parse_column(c + 1, end, false, &cpu_time);
+        if (c == NULL || cpu_time == 0) {
+            return LINE_MALFORMED;
+        }
+        if (cpu_time > SIM_TIME_MAX - total_cpu || io_time > SIM_TIME_MAX - total_io) {
+            return LINE_MALFORMED;
+        }
+        total_cpu += cpu_time;
+        total_io += io_time;
+        fields->num_phases++;
+    }
+    return LINE_PROCESS;
+}
+
+/**
+ * Parses one integer column of a process line
+ * Whitespace around the number and a leading + sign are accepted
+ * @param c First character of the column
+ * @param end Character after the last one of the line
+ * @param allow_negative Whether a leading - sign is accepted
+ * @param value Receives the value, which fits in a SimTime
+ * @return Character after the column (its comma or end), or NULL if the column is malformed
+ */
+static const char* parse_column(const char* c, const char* end, bool allow_negative, SimTime* value) {
+    bool negative = false;
+    while (c < end && (*c == ' ' || *c == '\t')) {
+        c++;
+    }
+    if (c < end && (*c == '+' || (allow_negative && *c == '-'))) {
+        negative = *c == '-';
+        c++;
+    }
+    if (c == end || *c < '0' || *c > '9') {
+        return NULL;
+    }
+    SimTime number = 0;
+    while (c < end && *c >= '0' && *c <= '9') {
+        int digit = *c++ - '0';
+        if (number > (SIM_TIME_MAX - digit) / 10) {
+            return NULL;
+        }
+        number = number * 10 + digit;
+    }
+    while (c < end && (*c == ' ' || *c == '\t')) {
+        c++;
+    }
+    if (c < end && *c != ',') {
+        return NULL;
+    }
+    *value = negative ? -number : number;
+    return c;
+}
+
+/**
+ * Makes sure the next job of a stream has been read
+ * Blocks until a complete line is available or the input ends
+ * @param reader Stream being read
+ * @return true if a job is pending, false at the end of the input
+ */
+static bool stream_peek(StreamReader* reader) {
+    while (!reader->pending) {
+        const char* line = reader->buffer + reader->start;
+        const char* limit = reader->buffer + reader->length;
+        const char* newline = memchr(line, '\n', limit - line);
+        if (newline != NULL) {
+            reader->start = newline + 1 - reader->buffer;
+            stream_take_line(reader, line, newline);
+            continue;
+        }
+        if (reader->at_end) {
+            // The last line has no trailing newline
+            reader->start = reader->length;
+            if (line < limit) {
+                stream_take_line(reader, line, limit);
+                continue;
+            }
+            return false;
+        }
+
+        // Keep the incomplete line and read more behind it
+        memmove(reader->buffer, line, limit - line);
+        reader->length = limit - line;
+        reader->start = 0;
+        if (reader->length == READ_BUFFER_SIZE) {
+            if (!reader->discarding) {
+                reader->malformed++;
+                reader->discarding = true;
+            }
+            reader->length = 0;
+        }
+        ssize_t got = read(reader->fd, reader->buffer + reader->length, READ_BUFFER_SIZE - reader->length);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            reader->at_end = true;
+            reader->failed = got < 0;
+        } else {
+            reader->length += got;
+        }
+    }
+    return true;
+}
+
+/**
+ * Parses one line of a stream into its pending job
+ * @param reader Stream being read
+ * @param line First character of the line
+ * @param end Character after the last one of the line
+ */
+static void stream_take_line(StreamReader* reader, const char* line, const char* end) {
+    ProcessLine fields;
+    if (reader->discarding) {
+        // The end of an overlong line, already counted
+        reader->discarding = false;
+        return;
+    }
+
+    LineStatus status = parse_process_line(line, end, &fields);
+    if (status == LINE_BLANK) {
+        return;
+    }
+    // Each live job would otherwise keep its bursts in the phase table
+    if (status == LINE_MALFORMED || fields.num_phases > 0) {
+        reader->malformed++;
+        return;
+    }
+
+    // Time cannot go back, so a late job arrives with the one before it
+    SimTime arrival_time = fields.arrival_time >= 0 ? fields.arrival_time : reader->count;
+    if (reader->count > 0 && arrival_time < reader->arrival_time) {
+        arrival_time = reader->arrival_time;
+    }
+    reader->burst_time = fields.burst_time;
+    reader->arrival_time = arrival_time;
+    reader->priority = fields.priority;
+    reader->pending = true;
+}
+
+/**
+ * Moves the pending job of a stream into the process table
+ * A retired entry is reused when there is one
+ * @param reader Stream with a pending job
+ * @param free_slots Entries of retired jobs
+ * @return Index of the job in the process table
+ */
+static int stream_admit(Simulator* sim, StreamReader* reader, RunQueue* free_slots) {
+    int index;
+    Process* p;
+    if (free_slots->size > 0) {
+        index = queue_pop(free_slots);
+        p = &sim->processes[index];
+        init_process(p, reader->count);
+    } else {
+        index = sim->num_processes;
+        p = add_process(sim);
+        p->id = reader->count;
+    }
+
+    p->burst_time = reader->burst_time;
+    p->remaining_time = reader->burst_time;
+    p->arrival_time = reader->arrival_time;
+    p->priority = reader->priority;
+    reader->count++;
+    reader->pending = false;
+    sim->ready_count++;
+    STATS_ADD(sim, events, 1);
+    STATS_READY(sim);
+    return index;
+}
+
+/**
+ * Prints the running averages of a streaming simulation
+ * The line goes through the trace buffer, which is flushed so it is seen at once
+ * @param current_time Current simulation time
+ * @param completed Jobs retired so far
+ * @param live Jobs admitted and not yet completed
+ * @param total_wait_time Sum of the wait times of the retired jobs
+ * @param total_turnaround_time Sum of the turnaround times of the retired jobs
+ */
+static void stream_report(Simulator* sim, SimTime current_time, int64_t completed, int live, TimeTotal total_wait_time, TimeTotal total_turnaround_time) {
+    char line[192];
+    print_pending_segment(sim);
+    snprintf(line, sizeof(line), "Report T%lld : %lld completed, %d live, average waiting time %.1f, average turnaround time %.1f\n",
+             (long long)current_time, (long long)completed, live,
+             completed > 0 ? (double)total_wait_time / completed : 0.0,
+             completed > 0 ? (double)total_turnaround_time / completed : 0.0);
+    output_text(&sim->output, line);
+    output_flush(&sim->output);
+}
+
+/**
+ * Grows the process table so it holds at least the given number of processes
+ * The table is a single contiguous block, so loading with an accurate count
+ * hint allocates exactly once
+ * @param count Number of processes to make room for
+ */
+void reserve_processes(Simulator* sim, int count) {
+    if (count <= sim->process_capacity) {
+        return;
+    }
+
+    Process* table = realloc(sim->processes, (size_t)count * sizeof(Process));
+    if (!table) {
+        printf("Error: Out of memory for %d processes\n", count);
+        exit(1);
+    }
+    sim->processes = table;
+    sim->process_capacity = count;
+}
+
+/**
+ * Appends a new process to the table, growing it geometrically when full
+ * @return Pointer to the new process, valid until the table grows again
+ */
+Process* add_process(Simulator* sim) {
+    if (sim->num_processes == sim->process_capacity) {
+        if (sim->process_capacity > INT_MAX / 2) {
+            if (sim->process_capacity == INT_MAX) {
+                printf("Error: Too many processes\n");
+                exit(1);
+            }
+            reserve_processes(sim, INT_MAX);
+        } else {
+            reserve_processes(sim, sim->process_capacity > 0 ? sim->process_capacity * 2 : INITIAL_PROCESS_CAPACITY);
+        }
+    }
+
+    Process* p = &sim->processes[sim->num_processes];
+    init_process(p, sim->num_processes);
+    sim->num_processes++;
+    sim->what_if.recorded = false;
+    return p;
+}
+
+/**
+ * Clears a process table entry for a new process without bursts
+ * @param p Entry to initialize
+ * @param id ID of the new process
+ */
+static void init_process(Process* p, int id) {
+    p->id = id;
+    p->burst_time = 0;
+    p->remaining_time = 0;
+    p->arrival_time = 0;
+    p->wait_time = 0;
+    p->turnaround_time = 0;
+    p->start_time = -1;
+    p->completion_time = 0;
+    p->priority = 0;
+    p->partition = 0;
+    p->io_time = 0;
+    p->first_phase = 0;
+    p->num_phases = 0;
+    p->phase = 0;
+    p->pending_time = 0;
+    p->blocked_time = 0;
+    p->completed = false;
+}
+
+/**
+ * Puts a process back at the start of its first CPU burst, before it arrives
+ * @param p Process to reset
+ */
+static void reset_process(Simulator* sim, Process* p) {
+    p->pending_time = 0;
+    for (int k = 0; k < p->num_phases; k++) {
+        p->pending_time += sim->phases[p->first_phase + 2 * k + 1];
+    }
+    p->remaining_time = p->burst_time - p->pending_time;
+    p->phase = 0;
+    p->blocked_time = 0;
+    p->wait_time = 0;
+    p->turnaround_time = 0;
+    p->start_time = -1;
+    p->completion_time = 0;
+    p->completed = false;
+}
+
+/**
+ * Appends an I/O burst and the CPU burst that follows it to a process
+ * A process's bursts are stored contiguously, so they can only be added to
+ * the process added last
+ * @param p Process returned by the last call to add_process()
+ * @param io_time Positive time the process spends blocked
+ * @param burst_time Positive CPU time of the burst after the I/O
+ */
+void add_io_burst(Simulator* sim, Process* p, SimTime io_time, SimTime burst_time) {
+    if (sim->phase_capacity - sim->num_phase_entries < 2) {
+        int capacity = sim->phase_capacity > 0 ? sim->phase_capacity * 2 : INITIAL_PHASE_CAPACITY;
+        SimTime* phases = realloc(sim->phases, (size_t)capacity * sizeof(SimTime));
+        if (!phases) {
+            printf("Error: Out of memory\n");
+            exit(1);
+        }
+        sim->phases = phases;
+        sim->phase_capacity = capacity;
+    }
+
+    if (p->num_phases == 0) {
+        p->first_phase = sim->num_phase_entries;
+    }
+    sim->phases[sim->num_phase_entries++] = io_time;
+    sim->phases[sim->num_phase_entries++] = burst_time;
+    p->num_phases++;
+    p->burst_time += burst_time;
+    p->io_time += io_time;
+}
+
+/**
+ * Releases the process table
+ */
+static void free_processes(Simulator* sim) {
+    free(sim->processes);
+    free(sim->phases);
+    sim->processes = NULL;
+    sim->num_processes = 0;
+    sim->process_capacity = 0;
+    sim->phases = NULL;
+    sim->num_phase_entries = 0;
+    sim->phase_capacity = 0;
+    sim->what_if.recorded = false;
+}
+
+/**
+ * Replaces the process table with a copy of another simulator's
+ * @param source Simulator holding the workload, left unchanged
+ */
+void simulator_copy_workload(Simulator* sim, const Simulator* source) {
+    reserve_processes(sim, source->num_processes);
+    if (source->num_processes > 0) {
+        memcpy(sim->processes, source->processes, (size_t)source->num_processes * sizeof(Process));
+    }
+    sim->num_processes = source->num_processes;
+
+    if (source->num_phase_entries > sim->phase_capacity) {
+        free(sim->phases);
+        sim->phases = malloc((size_t)source->num_phase_entries * sizeof(SimTime));
+        if (!sim->phases) {
+            printf("Error: Out of memory\n");
+            exit(1);
+        }
+        sim->phase_capacity = source->num_phase_entries;
+    }
+    if (source->num_phase_entries > 0) {
+        memcpy(sim->phases, source->phases, (size_t)source->num_phase_entries * sizeof(SimTime));
+    }
+    sim->num_phase_entries = source->num_phase_entries;
+    sim->what_if.recorded = false;
+}
+
+/**
+ * Fills in a workload like the benchmark's: 1000 processes with exponential
+ * bursts of mean 10 and Poisson arrivals keeping the processor 90% busy
+ * @param spec Spec to initialize
+ */
+void workload_default_spec(WorkloadSpec* spec) {
+    spec->count = 1000;
+    spec->burst_distribution = DIST_EXPONENTIAL;
+    spec->mean_burst = 10;
+    spec->arrival_distribution = DIST_EXPONENTIAL;
+    spec->mean_interarrival = 10 / 0.9;
+    spec->seed = 1;
+}
+
+/**
+ * Checks that a workload can be generated
+ * @param spec Workload to check
+ * @return Description of the problem, or NULL if there is none
+ */
+const char* workload_check_spec(const WorkloadSpec* spec) {
+    if (spec->count <= 0) {
+        return "The generated process count must be positive";
+    }
+    if (!(spec->mean_burst >= 1)) {
+        return "The mean generated burst must be at least 1";
+    }
+    if (!(spec->mean_interarrival >= 0)) {
+        return "The mean generated interarrival time cannot be negative";
+    }
+    // Leave room for the tails of the distributions in the simulation clock
+    if ((double)spec->count * (spec->mean_burst + spec->mean_interarrival) > SIM_TIME_MAX / 4) {
+        return "The generated workload would overflow the simulation clock";
+    }
+    return NULL;
+}
+
+/**
+ * Seeds a workload generator
+ * @param spec Workload to draw, accepted by workload_check_spec()
+ */
+static void generator_init(WorkloadGenerator* generator, const WorkloadSpec* spec) {
+    uint64_t seed = spec->seed;
+
+    generator->spec = spec;
+    generator->arrival = 0;
+    // SplitMix64 spreads any seed, including 0, over the whole state
+    for (int i = 0; i < 4; i++) {
+        uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        generator->state[i] = z ^ (z >> 31);
+    }
+}
+
+/**
+ * Advances the xoshiro256** generator
+ * @return Next 64 random bits
+ */
+static uint64_t generator_random(WorkloadGenerator* generator) {
+    uint64_t* s = generator->state;
+    uint64_t product = s[1] * 5;
+    uint64_t result = ((product << 7) | (product >> 57)) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 45) | (s[3] >> 19);
+    return result;
+}
+
+/**
+ * Draws a time from a distribution, cut off at GENERATED_TIME_CUTOFF times its mean
+ * @param distribution Distribution to draw from
+ * @param mean Mean of the distribution
+ * @return Time, not yet rounded
+ */
+static double generator_draw(WorkloadGenerator* generator, Distribution distribution, double mean) {
+    // Uniform in (0, 1], so its logarithm is finite
+    double u = ((generator_random(generator) >> 11) + 1) * (1.0 / 9007199254740992.0);
+    double value;
+
+    switch (distribution) {
+    case DIST_CONSTANT:
+        return mean;
+    case DIST_UNIFORM:
+        return 2 * mean * u;
+    case DIST_EXPONENTIAL:
+        value = -mean * log(u);
+        break;
+    default:
+        // Tail index 1.5 puts the scale at a third of the mean
+        value = mean / 3 * pow(u, -2.0 / 3.0);
+        break;
+    }
+    return value < mean * GENERATED_TIME_CUTOFF ? value : mean * GENERATED_TIME_CUTOFF;
+}
+
+/**
+ * Draws the next process; arrival times grow by whole gaps, so rounding does
+ * not drift the arrival rate
+ * @param burst_time Set to the CPU burst, rounded to a whole positive time
+ * @param arrival_time Set to the arrival time, rounded down
+ */
+static void generator_next(WorkloadGenerator* generator, SimTime* burst_time, SimTime* arrival_time) {
+    const WorkloadSpec* spec = generator->spec;
+    double burst = generator_draw(generator, spec->burst_distribution, spec->mean_burst) + 0.5;
+
+    *burst_time = burst >= 2 ? (burst < SIM_TIME_MAX / 4 ? (SimTime)burst : SIM_TIME_MAX / 4) : 1;
+    *arrival_time = generator->arrival < SIM_TIME_MAX / 2 ? (SimTime)generator->arrival : SIM_TIME_MAX / 2;
+    generator->arrival += generator_draw(generator, spec->arrival_distribution, spec->mean_interarrival);
+}
+
+/**
+ * Appends a synthetic workload to the process table without going through
+ * an input file; the processes are those write_workload() writes
+ * @param spec Workload to draw, accepted by workload_check_spec()
+ */
+void generate_workload(Simulator* sim, const WorkloadSpec* spec) {
+    WorkloadGenerator generator;
+    STATS_TIMER_START(load_start);
+
+    generator_init(&generator, spec);
+    reserve_processes(sim, sim->num_processes + spec->count);
+    for (int i = 0; i < spec->count; i++) {
+        Process* p = add_process(sim);
+        generator_next(&generator, &p->burst_time, &p->arrival_time);
+    }
+    STATS_TIMER_STOP(sim, load_start, load_seconds);
+}
+
+/**
+ * Writes a synthetic workload in the input file format, with its processes
+ * numbered from 0 and every arrival time given
+ * @param spec Workload to draw, accepted by workload_check_spec()
+ * @param file Stream to write the lines to
+ * @return Whether every line was written
+ */
+bool write_workload(const WorkloadSpec* spec, FILE* file) {
+    WorkloadGenerator generator;
+
+    generator_init(&generator, spec);
+    for (int i = 0; i < spec->count; i++) {
+        SimTime burst_time;
+        SimTime arrival_time;
+        generator_next(&generator, &burst_time, &arrival_time);
+        fprintf(file, "P%d,%lld,%lld\n", i, (long long)burst_time, (long long)arrival_time);
+    }
+    return fflush(file) == 0 && !ferror(file);
+}
+
+/**
+ * Writes the process table as a columnar workload, which read_input_file()
+ * loads without parsing; see load_columns_data() for the layout
+ * Processes are written in table order, which is the order loading numbers
+ * them in. The columnar format has no I/O bursts, and its columns are 32-bit
+ * @param file Stream to write to
+ * @param checksummed Whether to follow the columns with block checksums
+ * @return false if the table has I/O bursts or times past INT32_MAX, or writing failed
+ */
+bool write_workload_columns(const Simulator* sim, FILE* file, bool checksummed) {
+    if (sim->num_phase_entries > 0) {
+        return false;
+    }
+    for (int i = 0; i < sim->num_processes; i++) {
+        if (sim->processes[i].burst_time > INT32_MAX || sim->processes[i].arrival_time > INT32_MAX) {
+            return false;
+        }
+    }
+    ColumnWriter* writer = malloc(sizeof(ColumnWriter));
+    if (!writer) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    int n = sim->num_processes;
+    size_t data_size = NUM_COLUMNS * (((size_t)n * 4 + 7) / 8 * 8);
+    writer->file = file;
+    writer->used = 0;
+    writer->checksum = 0;
+    writer->block_used = 0;
+    writer->num_checksums = 0;
+    writer->checksums = malloc(((data_size + COLUMNS_BLOCK_SIZE - 1) / COLUMNS_BLOCK_SIZE + 1) * sizeof(uint64_t));
+    if (!writer->checksums) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+
+    unsigned char header[COLUMNS_HEADER_SIZE];
+    memcpy(header, COLUMNS_MAGIC, 4);
+    store_le(header + 4, COLUMNS_VERSION, 4);
+    store_le(header + 8, (uint64_t)n, 8);
+    store_le(header + 16, checksummed ? COLUMNS_CHECKSUMMED : 0, 4);
+    store_le(header + 20, COLUMNS_BLOCK_SIZE, 4);
+    fwrite(header, 1, sizeof(header), file);
+
+    for (int c = 0; c < NUM_COLUMNS; c++) {
+        for (int i = 0; i < n; i++) {
+            const Process* p = &sim->processes[i];
+            column_write(writer, (int32_t)(c == 0 ? p->burst_time : c == 1 ? p->arrival_time : c == 2 ? p->priority : p->partition));
+        }
+        if (n % 2 != 0) {
+            column_write(writer, 0);
+        }
+    }
+    column_flush(writer);
+    if (writer->block_used > 0) {
+        writer->checksums[writer->num_checksums++] = writer->checksum;
+    }
+    if (checksummed) {
+        for (size_t b = 0; b < writer->num_checksums; b++) {
+            unsigned char checksum[8];
+            store_le(checksum, writer->checksums[b], 8);
+            fwrite(checksum, 1, sizeof(checksum), file);
+        }
+    }
+    free(writer->checksums);
+    free(writer);
+    return fflush(file) == 0 && !ferror(file);
+}
+
+/**
+ * Appends a value to the column being written
+ * @param writer Writer of the file
+ * @param value Value to append
+ */
+static void column_write(ColumnWriter* writer, int32_t value) {
+    if (writer->used == sizeof(writer->buffer)) {
+        column_flush(writer);
+    }
+    store_le(writer->buffer + writer->used, (uint32_t)value, 4);
+    writer->used += 4;
+}
+
+/**
+ * Writes the buffered column data, checksumming it block by block
+ * @param writer Writer of the file
+ */
+static void column_flush(ColumnWriter* writer) {
+    // The buffer size divides the block size, so a flush never spans two blocks
+    writer->checksum = checksum_update(writer->checksum, writer->buffer, writer->used);
+    writer->block_used += writer->used;
+    if (writer->block_used == COLUMNS_BLOCK_SIZE) {
+        writer->checksums[writer->num_checksums++] = writer->checksum;
+        writer->checksum = 0;
+        writer->block_used = 0;
+    }
+    fwrite(writer->buffer, 1, writer->used, writer->file);
+    writer->used = 0;
+}
+
+/**
+ * Counts the processes in the table
+ * @return Number of processes
+ */
+int simulator_num_processes(const Simulator* sim) {
+    return sim->num_processes;
+}
+
+/**
+ * Gives read access to one process, including its results after a run
+ * @param index Index of the process, from 0 to simulator_num_processes() - 1
+ * @return The process
+ */
+const Process* simulator_process(const Simulator* sim, int index) {
+    return &sim->processes[index];
+}
+
+/**
+ * Gives the instrumentation counters of the last run and the time spent
+ * loading, simulating and reporting
+ * @return The counters, or NULL if the library was built without SCHEDULER_STATS
+ */
+const SimulatorStats* simulator_stats(const Simulator* sim) {
+#ifdef SCHEDULER_STATS
+    return &sim->stats;
+#else
+    (void)sim;
+    return NULL;
+#endif
+}
+
+/**
+ * Estimates a percentile of a metric over the processes completed by the
+ * last run, from a sketch kept as they complete; times below 128 are exact
+ * and larger ones are within 1/128 of the true value
+ * @param metric Metric to look up
+ * @param quantile Fraction of the processes at or below the result, from 0 to 1
+ * @return The percentile, or 0 if no process has completed
+ */
+SimTime simulator_percentile(const Simulator* sim, Metric metric, double quantile) {
+    const LatencySketch* sketch = &sim->sketches[metric];
+    if (sketch->total == 0) {
+        return 0;
+    }
+
+    // Rank of the result among the recorded times, counting from 1
+    double rank = ceil(quantile * (double)sketch->total);
+    uint64_t target = rank < 1 ? 1 : rank > (double)sketch->total ? sketch->total : (uint64_t)rank;
+    uint64_t seen = 0;
+    for (int b = 0; b < SKETCH_BUCKETS; b++) {
+        seen += sketch->counts[b];
+        if (seen >= target) {
+            SimTime value = sketch_value(b);
+            return value < sketch->max ? value : sketch->max;
+        }
+    }
+    return sketch->max;
+}
+
+/**
+ * Counts the simulated cores
+ * @return Number of cores
+ */
+int simulator_num_cores(const Simulator* sim) {
+    return sim->num_cores;
+}
+
+/**
+ * Gives read access to the work one core did in the last run
+ * Single-core runs leave the statistics zeroed
+ * @param core Index of the core, from 0 to simulator_num_cores() - 1
+ * @return The core's statistics
+ */
+const CoreStats* simulator_core_stats(const Simulator* sim, int core) {
+    return &sim->core_stats[core];
+}
+
+/**
+ * Runs the tick engine, one iteration per time unit: arrivals are admitted,
+ * the policy picks the process that executes, and the times are accounted
+ * Only called from the variants defined below, each of which passes
+ * constants for the policy, accounting mode and tracing, so that every test
+ * of them folds away and each variant compiles to its own loop. A policy
+ * adds its selection and its step after execution here, and a line to
+ * DEFINE_TICK_VARIANTS
+ * @param policy POLICY_FCFS, POLICY_SJF (preemptive) or POLICY_RR
+ * @param mode Accounting mode and layout of the simulator
+ * @param traced Whether a text or binary trace is produced, see trace_enabled()
+ * @param quantum Time slice for Round Robin
+ */
+static TICK_INLINE void tick_loop(Simulator* sim, Policy policy, TickMode mode, bool traced, int quantum) {
+    SimTime current_time = 0;   // Simulation time
+    int current_process = policy == POLICY_RR ? -1 : 0; // FCFS: first uncompleted process; RR: process holding the processor (-1 if none)
+    int preempted_process = -1; // Round Robin process whose quantum expired at the end of the last time unit
+    int time_in_quantum = 0;    // Time spent on the current Round Robin process in the current quantum
+    bool use_heap = policy == POLICY_SJF && mode == TICK_INCREMENTAL; // Scan accounting keeps the linear search
+    ProcessHeap heap;           // SJF ready queue used with incremental accounting
+    RunQueue queue;             // Round Robin ready queue in dispatch order
+    heap_init(&heap, use_heap ? sim->num_processes : 0, sim->processes);
+    queue_init(&queue, policy == POLICY_RR ? sim->num_processes : 0);
+    reset_accounting(sim);
+
+    // Loop until all processes are complete
+    while (!all_processes_complete(sim, mode)) {
+        int active_process = -1;    // Index of the process that executes during this time unit
+        int first_arrival = sim->next_arrival;
+        admit_arrivals(sim, current_time);
+
+        switch (policy) {
+        case POLICY_FCFS:
+            // Non-preemptive: the first uncompleted process runs once it has arrived
+            while (current_process < sim->num_processes && sim->processes[current_process].completed) {
+                current_process++;
+            }
+            if (current_process < sim->num_processes && sim->processes[current_process].arrival_time <= current_time) {
+                active_process = current_process;
+            }
+            break;
+        case POLICY_SJF:
+            // Preemptive: the shortest remaining time runs; the running
+            // process stays on top of the heap, as its key only decreases
+            if (use_heap) {
+                for (int i = first_arrival; i < sim->next_arrival; i++) {
+                    heap_push(&heap, i);
+                }
+                active_process = heap.size > 0 ? heap.items[0] : -1;
+            } else if (sim->ready_count > 0) {
+                Process* p = mode == TICK_SCAN_SOA ? sim->kernels->next_sjf(sim, current_time) :
+                             get_next_sjf_process(sim, current_time);
+                active_process = p != NULL ? (int)(p - sim->processes) : -1;
+            }
+            break;
+        default:
+            // New arrivals join the queue ahead of the preempted process;
+            // then the head of the queue is dispatched if the processor is free
+            for (int i = first_arrival; i < sim->next_arrival; i++) {
+                queue_push(&queue, i);
+            }
+            if (preempted_process >= 0) {
+                queue_push(&queue, preempted_process);
+                preempted_process = -1;
+            }
+            if (current_process < 0 && queue.size > 0) {
+                current_process = queue_pop(&queue);
+                time_in_quantum = 0;
+            }
+            active_process = current_process;
+            break;
+        }
+
+        if (active_process >= 0) {
+            Process* p = &sim->processes[active_process];
+            if (traced) {
+                print_tick(sim, mode, current_time, p);
+            }
+            execute_time_unit(sim, mode, p, current_time);
+
+            if (policy == POLICY_SJF && use_heap && p->completed) {
+                // A finished process leaves the ready queue
+                heap_pop(&heap);
+            } else if (policy == POLICY_RR) {
+                // The processor is freed by completion or by the end of the quantum
+                time_in_quantum++;
+                if (p->completed) {
+                    current_process = -1;
+                } else if (time_in_quantum == quantum) {
+                    preempted_process = current_process;
+                    current_process = -1;
+                }
+            }
+        }
+
+        // Update wait times and turnaround times
+        update_times(sim, mode, current_time, active_process);
+        // Increment current time
+        current_time++;
+    }
+    heap_free(&heap);
+    queue_free(&queue);
+    finish_accounting(sim);
+}
+
+// Defines the six tick-engine variants of a policy, one per accounting mode
+// with and without a trace, and the row of tick_variants that holds them
+#define DEFINE_TICK_VARIANT(name, policy, mode, traced) \
+    static void name(Simulator* sim, int quantum) { \
+        tick_loop(sim, policy, mode, traced, quantum); \
+    }
+#define DEFINE_TICK_VARIANTS(prefix, policy) \
+    DEFINE_TICK_VARIANT(prefix##_incremental, policy, TICK_INCREMENTAL, false) \
+    DEFINE_TICK_VARIANT(prefix##_incremental_traced, policy, TICK_INCREMENTAL, true) \
+    DEFINE_TICK_VARIANT(prefix##_scan, policy, TICK_SCAN_AOS, false) \
+    DEFINE_TICK_VARIANT(prefix##_scan_traced, policy, TICK_SCAN_AOS, true) \
+    DEFINE_TICK_VARIANT(prefix##_columns, policy, TICK_SCAN_SOA, false) \
+    DEFINE_TICK_VARIANT(prefix##_columns_traced, policy, TICK_SCAN_SOA, true)
+#define TICK_VARIANTS_ROW(prefix) { \
+        { prefix##_incremental, prefix##_incremental_traced }, \
+        { prefix##_scan, prefix##_scan_traced }, \
+        { prefix##_columns, prefix##_columns_traced } \
+    }
+
+DEFINE_TICK_VARIANTS(tick_fcfs, POLICY_FCFS)
+DEFINE_TICK_VARIANTS(tick_sjf, POLICY_SJF)
+DEFINE_TICK_VARIANTS(tick_round_robin, POLICY_RR)
+
+// Tick-engine variants by policy, accounting mode and whether they trace
+static void (*const tick_variants[POLICY_RR + 1][NUM_TICK_MODES][2])(Simulator* sim, int quantum) = {
+    TICK_VARIANTS_ROW(tick_fcfs),
+    TICK_VARIANTS_ROW(tick_sjf),
+    TICK_VARIANTS_ROW(tick_round_robin)
+};
+
+/**
+ * Simulates FCFS, preemptive SJF or Round Robin with the tick engine, using
+ * the variant specialized for the simulator's accounting mode and trace
+ * @param policy POLICY_FCFS, POLICY_SJF or POLICY_RR
+ * @param quantum Time slice for Round Robin
+ */
+static void simulate_ticks(Simulator* sim, Policy policy, int quantum) {
+    TickMode mode = sim->accounting == ACCOUNTING_INCREMENTAL ? TICK_INCREMENTAL :
+                    sim->layout == LAYOUT_SOA ? TICK_SCAN_SOA : TICK_SCAN_AOS;
+    tick_variants[policy][mode][trace_enabled(sim)](sim, quantum);
+}
+
+/**
+ * Checks that a simulator's options support a policy
+ * @param policy Scheduling policy
+ * @return Description of the problem, or NULL if run_simulation() can run the policy
+ */
+const char* simulator_check_policy(const Simulator* sim, Policy policy) {
+    if (sim->engine == ENGINE_ANALYTIC && policy != POLICY_FCFS) {
+        return "The analytic engine supports FCFS only";
+    }
+    // Only completion times are computed, not the segments a trace shows
+    if (sim->engine == ENGINE_ANALYTIC && (sim->trace_level >= TRACE_SEGMENTS || sim->binary_trace.file != NULL)) {
+        return "The analytic engine prints no trace";
+    }
+    if (policy == POLICY_MLFQ && sim->engine != ENGINE_EVENT) {
+        return "MLFQ requires the event engine";
+    }
+    if (policy == POLICY_MLFQ && sim->num_cores > 1) {
+        return "MLFQ runs on a single core";
+    }
+    if (policy == POLICY_CFS && sim->engine != ENGINE_EVENT) {
+        return "CFS requires the event engine";
+    }
+    if (policy == POLICY_CFS && sim->num_cores > 1) {
+        return "CFS runs on a single core";
+    }
+    // The tick engine has no blocked state
+    if (sim->num_phase_entries > 0 && sim->engine != ENGINE_EVENT) {
+        return "I/O bursts require the event engine";
+    }
+    if (sim->checkpoint.filename != NULL &&
+        (sim->engine != ENGINE_EVENT || sim->num_cores > 1 || policy == POLICY_MLFQ || policy == POLICY_CFS)) {
+        return "Checkpoints support FCFS, SJF and Round Robin on the event engine with one core";
+    }
+    if (sim->what_if.interval > 0 &&
+        (sim->engine != ENGINE_EVENT || sim->num_cores > 1 || policy == POLICY_MLFQ || policy == POLICY_CFS)) {
+        return "What-if runs support FCFS, SJF and Round Robin on the event engine with one core";
+    }
+    if (!horizon_fits(sim)) {
+#ifdef SCHEDULER_TIME64
+        return "The workload runs past the largest simulation time";
+#else
+        return "The workload runs past 2^31 time units; build with make TIME64=1";
+#endif
+    }
+    return NULL;
+}
+
+/**
+ * Checks that the times of a run fit SimTime: the policies never idle with
+ * work ready, so every process finishes by the last arrival plus all the CPU
+ * and I/O time of the workload, migrations between cores aside
+ * @return true if the bound fits SimTime
+ */
+static bool horizon_fits(const Simulator* sim) {
+    TimeTotal work = 0;
+    SimTime last_arrival = 0;
+    for (int i = 0; i < sim->num_processes; i++) {
+        const Process* p = &sim->processes[i];
+        work += (TimeTotal)p->burst_time + p->io_time;
+        if (p->arrival_time > last_arrival) {
+            last_arrival = p->arrival_time;
+        }
+    }
+    return work <= (TimeTotal)SIM_TIME_MAX - last_arrival;
+}
+
+/**
+ * Runs one simulation of the process table with the simulator's engine
+ * The processes start over from their first CPU burst, so the same workload
+ * can be simulated repeatedly. The engines take arrivals in table order, so
+ * the table is first sorted by arrival time, ties in ID order
+ * @param policy Scheduling policy, see simulator_check_policy()
+ * @param quantum Time quantum for Round Robin
+ */
+void run_simulation(Simulator* sim, Policy policy, int quantum) {
+    STATS_TIMER_START(simulate_start);
+    sort_by_arrival(sim);
+
+    // The analytic engine writes every field a reset would
+    if (sim->engine != ENGINE_ANALYTIC) {
+        for (int i = 0; i < sim->num_processes; i++) {
+            reset_process(sim, &sim->processes[i]);
+        }
+    }
+    memset(sim->core_stats, 0, (size_t)sim->num_cores * sizeof(CoreStats));
+    sim->checkpoint.policy = policy;
+    sim->checkpoint.quantum = quantum;
+    sim->checkpoint.last_time = monotonic_clock();
+    sim->checkpoint.countdown = CHECKPOINT_POLL_ITERATIONS;
+
+    // A recorded run keeps snapshots from its first loop iteration on
+    WhatIfLog* log = &sim->what_if;
+    log->recorded = false;
+    log->recording = log->interval > 0 && sim->engine == ENGINE_EVENT && sim->num_cores == 1 &&
+                     policy != POLICY_MLFQ && policy != POLICY_CFS;
+    log->policy = policy;
+    log->quantum = quantum;
+    log->countdown = 1;
+    log->num_snapshots = 0;
+    log->ready_used = 0;
+    log->blocked_used = 0;
+    log->live_used = 0;
+    sim->polled = sim->checkpoint.filename != NULL || log->recording;
+
+    if (sim->num_cores > 1) {
+        simulate_multicore(sim, policy, quantum);
+        STATS_TIMER_STOP(sim, simulate_start, simulate_seconds);
+        return;
+    }
+
+    switch (policy) {
+    case POLICY_FCFS:
+        if (sim->engine == ENGINE_TICK) {
+            simulate_ticks(sim, policy, quantum);
+        } else if (sim->engine == ENGINE_ANALYTIC) {
+            simulate_fcfs_analytic(sim);
+        } else {
+            simulate_fcfs_events(sim);
+        }
+        break;
+    case POLICY_SJF:
+        if (sim->engine == ENGINE_TICK) {
+            simulate_ticks(sim, policy, quantum);
+        } else {
+            simulate_sjf_events(sim);
+        }
+        break;
+    case POLICY_RR:
+        if (sim->engine == ENGINE_TICK) {
+            simulate_ticks(sim, policy, quantum);
+        } else {
+            simulate_round_robin_events(sim, quantum);
+        }
+        break;
+    case POLICY_MLFQ:
+        simulate_mlfq_events(sim);
+        break;
+    case POLICY_CFS:
+        simulate_cfs_events(sim);
+        break;
+    }
+    if (log->recording) {
+        finish_recording(sim);
+    }
+    STATS_TIMER_STOP(sim, simulate_start, simulate_seconds);
+}
+
+/**
+ * Computes the aggregate results of the simulation that just finished
+ * @param summary Receives the averages and the makespan
+ */
+void summarize_run(const Simulator* sim, RunSummary* summary) {
+    TimeTotal total_wait_time = 0;
+    TimeTotal total_turnaround_time = 0;
+    SimTime makespan = 0;
+
+    for (int i = 0; i < sim->num_processes; i++) {
+        total_wait_time += sim->processes[i].wait_time;
+        total_turnaround_time += sim->processes[i].turnaround_time;
+        if (sim->processes[i].completion_time > makespan) {
+            makespan = sim->processes[i].completion_time;
+        }
+    }
+    summary->average_wait_time = sim->num_processes > 0 ? (double)total_wait_time / sim->num_processes : 0;
+    summary->average_turnaround_time = sim->num_processes > 0 ? (double)total_turnaround_time / sim->num_processes : 0;
+    summary->makespan = makespan;
+    summary->segments = sim->segments;
+}
+
+/**
+ * Checks that a simulator's options support streaming a policy
+ * @param policy Scheduling policy
+ * @return Description of the problem, or NULL if run_stream() can run the policy
+ */
+const char* simulator_check_stream(const Simulator* sim, Policy policy) {
+    if (sim->engine != ENGINE_EVENT) {
+        return "Streaming requires the event engine";
+    }
+    if (sim->num_cores > 1) {
+        return "Streaming runs on a single core";
+    }
+    if (policy != POLICY_FCFS && policy != POLICY_SJF && policy != POLICY_RR) {
+        return "Streaming supports FCFS, SJF and Round Robin";
+    }
+    return NULL;
+}
+
+/**
+ * Simulates jobs read from a file descriptor as they arrive
+ * Jobs use the input file format without I/O bursts and must be listed in
+ * arrival order; an earlier arrival time is raised to the one before it. A
+ * job is read only once the simulation needs to know the next arrival, so the
+ * input can be a pipe or socket fed in real time. Completed jobs are retired
+ * and their entries in the process table reused, so memory grows with the
+ * number of live jobs rather than the length of the input. The process table
+ * is replaced and only holds live jobs meanwhile
+ * @param policy FCFS, SJF or Round Robin, see simulator_check_stream()
+ * @param quantum Time quantum for Round Robin
+ * @param fd Descriptor to read jobs from until its end
+ * @param report_interval Time units between reports of the running averages, 0 for none
+ * @param summary Receives the averages and the makespan over all jobs
+ * @return Number of malformed lines that were skipped, or -1 if reading failed
+ */
+int run_stream(Simulator* sim, Policy policy, int quantum, int fd, int report_interval, RunSummary* summary) {
+    STATS_TIMER_START(simulate_start);
+    SimTime current_time = 0;    // Simulation time
+    int preempted_process = -1;  // Round Robin process whose quantum expired at the end of the last slice
+    SimTime next_report = report_interval > 0 ? report_interval : SIM_TIME_MAX;
+    int64_t completed = 0;       // Jobs retired so far
+    TimeTotal total_wait_time = 0;
+    TimeTotal total_turnaround_time = 0;
+    SimTime makespan = 0;
+    ProcessHeap heap;            // SJF ready queue; the running process stays on top
+    RunQueue queue;              // FCFS and Round Robin ready queue
+    RunQueue free_slots;         // Process table entries of retired jobs
+    StreamReader reader = { 0 };
+    reader.fd = fd;
+    reader.buffer = malloc(READ_BUFFER_SIZE);
+    if (!reader.buffer) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+
+    sim->num_processes = 0;
+    sim->num_phase_entries = 0;
+    sim->what_if.recorded = false;
+    heap_init(&heap, 0, sim->processes);
+    queue_init(&queue, 0);
+    queue_init(&free_slots, 0);
+    reset_accounting(sim);
+
+    for (;;) {
+        // Admit every job that has arrived by now
+        while (stream_peek(&reader) && reader.arrival_time <= current_time) {
+            int index = stream_admit(sim, &reader, &free_slots);
+            heap.processes = sim->processes;   // The table may have grown
+            if (policy == POLICY_SJF) {
+                if (heap.size == heap.capacity) {
+                    heap_grow(&heap);
+                }
+                heap_push(&heap, index);
+            } else {
+                if (queue.size == queue.capacity) {
+                    queue_grow(&queue);
+                }
+                queue_push(&queue, index);
+            }
+        }
+        if (preempted_process >= 0) {
+            if (queue.size == queue.capacity) {
+                queue_grow(&queue);
+            }
+            queue_push(&queue, preempted_process);
+            preempted_process = -1;
+        }
+
+        int waiting = policy == POLICY_SJF ? heap.size : queue.size;
+        if (waiting == 0) {
+            // Nothing is live: wait for the next job, or stop at the end of the input
+            if (!stream_peek(&reader)) {
+                break;
+            }
+            current_time = reader.arrival_time;
+            continue;
+        }
+
+        int index = policy == POLICY_SJF ? heap.items[0] : queue_pop(&queue);
+        Process* p = &sim->processes[index];
+        SimTime end = current_time + p->remaining_time;
+        if (policy == POLICY_RR && quantum < p->remaining_time) {
+            end = current_time + quantum;
+        }
+        // SJF may be preempted by the next arrival
+        if (policy == POLICY_SJF && stream_peek(&reader) && reader.arrival_time < end) {
+            end = reader.arrival_time;
+        }
+        run_segment(sim, p, current_time, end);
+        current_time = end;
+
+        if (p->remaining_time == 0) {
+            if (policy == POLICY_SJF) {
+                heap_pop(&heap);
+            }
+            complete_process(sim, p, current_time);
+            total_wait_time += p->wait_time;
+            total_turnaround_time += p->turnaround_time;
+            makespan = current_time;
+            completed++;
+            if (free_slots.size == free_slots.capacity) {
+                queue_grow(&free_slots);
+            }
+            queue_push(&free_slots, index);
+        } else if (policy == POLICY_RR) {
+            preempted_process = index;
+        }
+
+        if (current_time >= next_report) {
+            int live = policy == POLICY_SJF ? heap.size : queue.size + (preempted_process >= 0 ? 1 : 0);
+            stream_report(sim, current_time, completed, live, total_wait_time, total_turnaround_time);
+            while (next_report <= current_time && next_report <= SIM_TIME_MAX - report_interval) {
+                next_report += report_interval;
+            }
+            if (next_report <= current_time) {
+                next_report = SIM_TIME_MAX;
+            }
+        }
+    }
+
+    finish_accounting(sim);
+    heap_free(&heap);
+    queue_free(&queue);
+    queue_free(&free_slots);
+    free(reader.buffer);
+    sim->num_processes = 0;
+
+    summary->average_wait_time = completed > 0 ? (double)total_wait_time / completed : 0;
+    summary->average_turnaround_time = completed > 0 ? (double)total_turnaround_time / completed : 0;
+    summary->makespan = makespan;
+    summary->segments = sim->segments;
+    STATS_TIMER_STOP(sim, simulate_start, simulate_seconds);
+    return reader.failed ? -1 : reader.malformed;
+}
+
+/**
+ * Checks that a simulator's options support a sharded run of a policy
+ * @param policy Scheduling policy
+ * @return Description of the problem, or NULL if run_sharded() can run the policy
+ */
+const char* simulator_check_shards(const Simulator* sim, Policy policy) {
+    if (sim->num_cores > 1) {
+        return "Each shard runs on a single core";
+    }
+    if (sim->checkpoint.filename != NULL) {
+        return "A sharded run cannot be checkpointed";
+    }
+    return simulator_check_policy(sim, policy);
+}
+
+/**
+ * Simulates each partition of the process table on its own processor, as
+ * independent runs spread over a pool of worker threads
+ * The shards are dealt out largest first, one deque per worker; a worker
+ * whose deque runs dry steals the largest shard left on the deque with the
+ * most processes queued, so a few huge partitions do not leave the other
+ * workers idle. Each shard runs silently on the worker's own simulator and
+ * its results are copied back into the process table, so the statistics,
+ * percentiles and summary of the whole table then read as after
+ * run_simulation(). Counters are summed over the shards, except the ready
+ * high-water mark, which is the largest of any shard
+ * @param policy Scheduling policy, see simulator_check_shards()
+ * @param quantum Time quantum for Round Robin
+ * @param num_threads Number of worker threads; no more than one per shard is started
+ * @return Number of shards
+ */
+int run_sharded(Simulator* sim, Policy policy, int quantum, int num_threads) {
+    STATS_TIMER_START(simulate_start);
+    sort_by_arrival(sim);
+    memset(sim->sketches, 0, sizeof(sim->sketches));
+    sim->segments = 0;
+    sim->what_if.recorded = false;
+#ifdef SCHEDULER_STATS
+    double load_seconds = sim->stats.load_seconds;
+    memset(&sim->stats, 0, sizeof(sim->stats));
+    sim->stats.load_seconds = load_seconds;
+#endif
+
+    // Group the table by partition as (partition, index) pairs, keeping the
+    // arrival order within each partition
+    int n = sim->num_processes;
+    int* keys = malloc((size_t)(n > 0 ? n : 1) * 2 * sizeof(int));
+    int* order = malloc((size_t)(n > 0 ? n : 1) * sizeof(int));
+    if (!keys || !order) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    for (int i = 0; i < n; i++) {
+        keys[2 * i] = sim->processes[i].partition;
+        keys[2 * i + 1] = i;
+    }
+    qsort(keys, n, 2 * sizeof(int), compare_partitions);
+    int num_shards = 0;
+    for (int i = 0; i < n; i++) {
+        order[i] = keys[2 * i + 1];
+        if (i == 0 || keys[2 * i] != keys[2 * i - 2]) {
+            num_shards++;
+        }
+    }
+    Shard* shards = malloc((size_t)(num_shards > 0 ? num_shards : 1) * sizeof(Shard));
+    if (!shards) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    for (int i = 0, s = -1; i < n; i++) {
+        if (i == 0 || keys[2 * i] != keys[2 * i - 2]) {
+            s++;
+            shards[s].first = i;
+            shards[s].count = 0;
+        }
+        shards[s].count++;
+    }
+    free(keys);
+    qsort(shards, num_shards, sizeof(Shard), compare_shard_sizes);
+
+    // Deal the shards out in turn, so every deque is also largest first
+    int num_workers = num_threads < num_shards ? num_threads : num_shards;
+    if (num_workers < 1) {
+        num_workers = 1;
+    }
+    ShardPool pool;
+    pool.sim = sim;
+    pool.policy = policy;
+    pool.quantum = quantum;
+    pool.order = order;
+    pool.shards = shards;
+    pool.num_workers = num_workers;
+    pool.deques = malloc((size_t)num_workers * sizeof(ShardDeque));
+    ShardWorker* workers = calloc(num_workers, sizeof(ShardWorker));
+    pthread_t* threads = malloc((size_t)num_workers * sizeof(pthread_t));
+    if (!pool.deques || !workers || !threads) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    for (int w = 0; w < num_workers; w++) {
+        ShardDeque* deque = &pool.deques[w];
+        pthread_mutex_init(&deque->lock, NULL);
+        deque->shards = malloc((size_t)(num_shards / num_workers + 1) * sizeof(int));
+        if (!deque->shards) {
+            printf("Error: Out of memory\n");
+            exit(1);
+        }
+        deque->head = 0;
+        deque->tail = 0;
+        deque->queued = 0;
+    }
+    for (int s = 0; s < num_shards; s++) {
+        ShardDeque* deque = &pool.deques[s % num_workers];
+        deque->shards[deque->tail++] = s;
+        deque->queued += shards[s].count;
+    }
+
+    for (int w = 0; w < num_workers; w++) {
+        workers[w].pool = &pool;
+        workers[w].index = w;
+        if (pthread_create(&threads[w], NULL, shard_worker, &workers[w]) != 0) {
+            printf("Error: Could not start worker thread\n");
+            exit(1);
+        }
+    }
+    for (int w = 0; w < num_workers; w++) {
+        pthread_join(threads[w], NULL);
+    }
+
+    // Merge what the workers gathered into the simulator
+    for (int w = 0; w < num_workers; w++) {
+        for (int m = 0; m < NUM_METRICS; m++) {
+            sketch_merge(&sim->sketches[m], &workers[w].sketches[m]);
+        }
+        sim->segments += workers[w].segments;
+#ifdef SCHEDULER_STATS
+        stats_merge(&sim->stats, &workers[w].stats);
+        sim->stats.shard_steals += workers[w].steals;
+#endif
+        pthread_mutex_destroy(&pool.deques[w].lock);
+        free(pool.deques[w].shards);
+    }
+    free(threads);
+    free(workers);
+    free(pool.deques);
+    free(shards);
+    free(order);
+    STATS_TIMER_STOP(sim, simulate_start, simulate_seconds);
+    return num_shards;
+}
+
+/**
+ * Thread body of a sharded run
+ * Takes shards until none are left anywhere, simulating each on a private
+ * simulator that is reused between shards
+ * @param arg The worker's ShardWorker
+ * @return NULL
+ */
+static void* shard_worker(void* arg) {
+    ShardWorker* worker = arg;
+    ShardPool* pool = worker->pool;
+    Simulator* shard = shard_simulator_create(pool->sim);
+
+    for (;;) {
+        bool stolen;
+        int s = shard_take(pool, worker->index, &stolen);
+        if (s < 0) {
+            break;
+        }
+        if (stolen) {
+            worker->steals++;
+        }
+
+        // A shard keeps the table's arrival order, so its processes stay in
+        // place and map back one to one; only the partition's own entries
+        // are written, so no other worker touches them
+        const int* indices = pool->order + pool->shards[s].first;
+        int count = pool->shards[s].count;
+        shard_load(shard, pool->sim, indices, count);
+        run_simulation(shard, pool->policy, pool->quantum);
+        for (int k = 0; k < count; k++) {
+            Process* p = &pool->sim->processes[indices[k]];
+            int first_phase = p->first_phase;
+            *p = shard->processes[k];
+            p->first_phase = first_phase;
+        }
+
+        for (int m = 0; m < NUM_METRICS; m++) {
+            sketch_merge(&worker->sketches[m], &shard->sketches[m]);
+        }
+        worker->segments += shard->segments;
+#ifdef SCHEDULER_STATS
+        stats_merge(&worker->stats, &shard->stats);
+#endif
+    }
+
+    simulator_destroy(shard);
+    return NULL;
+}
+
+/**
+ * Takes the next shard for a worker: the largest left on its own deque, or
+ * failing that the largest left on the deque with the most processes queued
+ * @param worker Index of the worker
+ * @param stolen Set to whether the shard came from another worker's deque
+ * @return Index of the shard, or -1 once every deque is empty
+ */
+static int shard_take(ShardPool* pool, int worker, bool* stolen) {
+    for (int attempt = 0;; attempt++) {
+        int victim = worker;
+        if (attempt > 0) {
+            // Sizes only shrink, so a victim found empty by the time it is
+            // locked just means looking again
+            int64_t most = 0;
+            victim = -1;
+            for (int w = 0; w < pool->num_workers; w++) {
+                ShardDeque* deque = &pool->deques[w];
+                pthread_mutex_lock(&deque->lock);
+                int64_t queued = deque->queued;
+                pthread_mutex_unlock(&deque->lock);
+                if (queued > most) {
+                    most = queued;
+                    victim = w;
+                }
+            }
+            if (victim < 0) {
+                return -1;
+            }
+        }
+
+        ShardDeque* deque = &pool->deques[victim];
+        int s = -1;
+        pthread_mutex_lock(&deque->lock);
+        if (deque->head < deque->tail) {
+            s = deque->shards[deque->head++];
+            deque->queued -= pool->shards[s].count;
+        }
+        pthread_mutex_unlock(&deque->lock);
+        if (s >= 0) {
+            *stolen = victim != worker;
+            return s;
+        }
+    }
+}
+
+/**
+ * Creates a silent single-core simulator with the engine and policy options
+ * of another, for running its shards
+ * @param sim Simulator the shards come from
+ * @return New simulator, to be released with simulator_destroy()
+ */
+static Simulator* shard_simulator_create(const Simulator* sim) {
+    SimulatorOptions options;
+    simulator_default_options(&options);
+    options.engine = sim->engine;
+    options.accounting = sim->accounting;
+    options.layout = sim->layout;
+    options.trace_level = TRACE_SUMMARY;
+    options.mlfq_levels = sim->mlfq_levels;
+    memcpy(options.mlfq_quanta, sim->mlfq_quanta, sizeof(options.mlfq_quanta));
+    options.mlfq_boost_period = sim->mlfq_boost_period;
+    options.cfs_latency = sim->cfs_latency;
+    options.cfs_min_granularity = sim->cfs_min_granularity;
+    options.num_threads = sim->num_threads;
+
+    Simulator* shard = simulator_create(&options);
+    shard->kernels = sim->kernels;
+    return shard;
+}
+
+/**
+ * Replaces the process table of a shard's simulator with some processes of
+ * another table and their bursts
+ * @param shard Simulator to load
+ * @param sim Simulator holding the whole process table
+ * @param indices Indices of the processes in sim, in arrival order
+ * @param count Number of processes
+ */
+static void shard_load(Simulator* shard, const Simulator* sim, const int* indices, int count) {
+    int entries = 0;
+    for (int k = 0; k < count; k++) {
+        entries += 2 * sim->processes[indices[k]].num_phases;
+    }
+    if (entries > shard->phase_capacity) {
+        free(shard->phases);
+        shard->phases = malloc((size_t)entries * sizeof(SimTime));
+        if (!shard->phases) {
+            printf("Error: Out of memory\n");
+            exit(1);
+        }
+        shard->phase_capacity = entries;
+    }
+    reserve_processes(shard, count);
+
+    shard->num_phase_entries = 0;
+    for (int k = 0; k < count; k++) {
+        Process* p = &shard->processes[k];
+        *p = sim->processes[indices[k]];
+        if (p->num_phases > 0) {
+            memcpy(shard->phases + shard->num_phase_entries, sim->phases + p->first_phase,
+                   (size_t)(2 * p->num_phases) * sizeof(SimTime));
+            p->first_phase = shard->num_phase_entries;
+            shard->num_phase_entries += 2 * p->num_phases;
+        }
+    }
+    shard->num_processes = count;
+}
+
+/**
+ * Simulates First Come First Served scheduling with the event engine
+ * Each dispatch runs a whole CPU burst as a single segment; a process
+ * returning from I/O rejoins the tail of the queue behind new arrivals
+ */
+static void simulate_fcfs_events(Simulator* sim) {
+    SimTime current_time = 0; // Simulation time
+    int woken;               // Process whose I/O burst has completed
+    RunQueue ready;          // Ready queue in dispatch order
+    queue_init(&ready, sim->num_processes);
+    begin_event_run(sim, &current_time, NULL, &ready, NULL);
+
+    while (sim->completed_count < sim->num_processes) {
+        if (sim->polled && event_loop_poll(sim, current_time, -1, &ready, NULL)) {
+            break;
+        }
+        int first_arrival = sim->next_arrival;
+        admit_arrivals(sim, current_time);
+        for (int i = first_arrival; i < sim->next_arrival; i++) {
+            queue_push(&ready, i);
+        }
+        while ((woken = wake_process(sim, current_time)) >= 0) {
+            queue_push(&ready, woken);
+        }
+
+        if (ready.size == 0) {
+            // Nothing is ready: jump to the next arrival or I/O completion
+            current_time = next_ready_time(sim);
+            continue;
+        }
+
+        Process* p = &sim->processes[queue_pop(&ready)];
+        SimTime end = current_time + p->remaining_time;
+        run_segment(sim, p, current_time, end);
+        current_time = end;
+        end_burst(sim, p, current_time);
+    }
+    queue_free(&ready);
+    finish_accounting(sim);
+}
+
+/**
+ * Simulates First Come First Served scheduling in closed form
+ * Without I/O each process completes at max(c, a) + b, where c is the
+ * completion time of the process before it, a its arrival and b its burst.
+ * Such steps compose into max(c + shift, floor), so the table is split into
+ * ranges that threads reduce to one step each; a sequential pass over the
+ * ranges gives the time each one starts from, and the threads then fill in
+ * their processes. The results match the other engines, but nothing is
+ * traced and no segments are counted
+ */
+static void simulate_fcfs_analytic(Simulator* sim) {
+    reset_accounting(sim);
+    int n = sim->num_processes;
+    int num_threads = sim->num_threads;
+    if (num_threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cpus > 0 ? (int)cpus : 1;
+    }
+    // Small ranges are not worth a thread
+    int num_ranges = n / ANALYTIC_MIN_RANGE < num_threads ? n / ANALYTIC_MIN_RANGE : num_threads;
+    if (num_ranges < 1) {
+        num_ranges = 1;
+    }
+    AnalyticRange* ranges = calloc(num_ranges, sizeof(AnalyticRange));
+    if (!ranges) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    for (int r = 0; r < num_ranges; r++) {
+        ranges[r].sim = sim;
+        ranges[r].first = (int)((int64_t)n * r / num_ranges);
+        ranges[r].end = (int)((int64_t)n * (r + 1) / num_ranges);
+    }
+
+    // A single range starts from time 0 and needs no reduction
+    if (num_ranges > 1) {
+        analytic_run(ranges, num_ranges, analytic_compose);
+    }
+    int64_t completion = 0;
+    for (int r = 0; r < num_ranges; r++) {
+        ranges[r].previous = completion;
+        completion = completion + ranges[r].shift > ranges[r].floor ? completion + ranges[r].shift : ranges[r].floor;
+    }
+    analytic_run(ranges, num_ranges, analytic_fill);
+
+    for (int r = 0; r < num_ranges; r++) {
+        for (int m = 0; m < NUM_METRICS; m++) {
+            sketch_merge(&sim->sketches[m], &ranges[r].sketches[m]);
+        }
+    }
+    free(ranges);
+    sim->completed_count = n;
+    sim->next_arrival = n;
+    finish_accounting(sim);
+}
+
+/**
+ * Reduces the processes of a range to the step the whole range takes
+ * @param arg AnalyticRange whose shift and floor are set
+ * @return NULL
+ */
+static void* analytic_compose(void* arg) {
+    AnalyticRange* range = arg;
+    const Process* processes = range->sim->processes;
+    // The identity for completion times, which are never negative
+    int64_t shift = 0;
+    int64_t floor = 0;
+    for (int i = range->first; i < range->end; i++) {
+        int64_t burst_time = processes[i].burst_time;
+        int64_t ready = processes[i].arrival_time + burst_time;
+        floor = floor + burst_time > ready ? floor + burst_time : ready;
+        shift += burst_time;
+    }
+    range->shift = shift;
+    range->floor = floor;
+    return NULL;
+}
+
+/**
+ * Fills in the results of the processes of a range, starting from the
+ * completion time of the process before it
+ * @param arg AnalyticRange whose previous completion time is set
+ * @return NULL
+ */
+static void* analytic_fill(void* arg) {
+    AnalyticRange* range = arg;
+    Process* processes = range->sim->processes;
+    SimTime completion_time = range->previous;
+    for (int i = range->first; i < range->end; i++) {
+        Process* p = &processes[i];
+        p->start_time = completion_time > p->arrival_time ? completion_time : p->arrival_time;
+        completion_time = p->start_time + p->burst_time;
+        p->completion_time = completion_time;
+        p->wait_time = completion_time - p->arrival_time - p->burst_time;
+        p->turnaround_time = completion_time - p->arrival_time - 1;
+        p->remaining_time = 0;
+        p->pending_time = 0;
+        p->phase = 0;
+        p->blocked_time = 0;
+        p->completed = true;
+        sketch_add(&range->sketches[METRIC_WAIT], p->wait_time);
+        sketch_add(&range->sketches[METRIC_TURNAROUND], p->turnaround_time);
+        sketch_add(&range->sketches[METRIC_RESPONSE], p->start_time - p->arrival_time);
+    }
+    return NULL;
+}
+
+/**
+ * Runs one pass of the analytic engine over every range, the first on the
+ * calling thread and each other on a thread of its own
+ * @param ranges Ranges of the process table
+ * @param num_ranges Number of ranges
+ * @param pass analytic_compose() or analytic_fill()
+ */
+static void analytic_run(AnalyticRange* ranges, int num_ranges, void* (*pass)(void* arg)) {
+    if (num_ranges == 1) {
+        pass(&ranges[0]);
+        return;
+    }
+    pthread_t* threads = malloc((size_t)num_ranges * sizeof(pthread_t));
+    if (!threads) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    for (int r = 1; r < num_ranges; r++) {
+        if (pthread_create(&threads[r], NULL, pass, &ranges[r]) != 0) {
+            printf("Error: Could not start worker thread\n");
+            exit(1);
+        }
+    }
+    pass(&ranges[0]);
+    for (int r = 1; r < num_ranges; r++) {
+        pthread_join(threads[r], NULL);
+    }
+    free(threads);
+}
+
+/**
+ * Simulates Shortest Job First scheduling with the event engine
+ * The selected process runs until its CPU burst ends or the next arrival or
+ * I/O completion, which are the only points at which a preemption can
+ * happen. Ready processes are kept in a heap, so each arrival and completion
+ * costs O(log N)
+ */
+static void simulate_sjf_events(Simulator* sim) {
+    SimTime current_time = 0; // Simulation time
+    int woken;               // Process whose I/O burst has completed
+    ProcessHeap ready;       // Ready queue ordered by remaining time
+    heap_init(&ready, sim->num_processes, sim->processes);
+    begin_event_run(sim, &current_time, NULL, NULL, &ready);
+
+    while (sim->completed_count < sim->num_processes) {
+        if (sim->polled && event_loop_poll(sim, current_time, -1, NULL, &ready)) {
+            break;
+        }
+        int first_arrival = sim->next_arrival;
+        admit_arrivals(sim, current_time);
+        for (int i = first_arrival; i < sim->next_arrival; i++) {
+            heap_push(&ready, i);
+        }
+        while ((woken = wake_process(sim, current_time)) >= 0) {
+            heap_push(&ready, woken);
+        }
+
+        if (ready.size == 0) {
+            // Nothing is ready: jump to the next arrival or I/O completion
+            current_time = next_ready_time(sim);
+            continue;
+        }
+
+        // An arrival only preempts when its burst beats the remaining time on top
+        Process* p = &sim->processes[ready.items[0]];
+
+        // Run until the burst ends or until the next process may preempt
+        SimTime end = current_time + p->remaining_time;
+        SimTime next_ready = next_ready_time(sim);
+        if (next_ready < end) {
+            end = next_ready;
+        }
+        run_segment(sim, p, current_time, end);
+        current_time = end;
+
+        if (p->remaining_time == 0) {
+            heap_pop(&ready);
+            end_burst(sim, p, current_time);
+        }
+    }
+    heap_free(&ready);
+    finish_accounting(sim);
+}
+
+/**
+ * Simulates Round Robin scheduling with the event engine
+ * Each dispatch runs one quantum, or less if the CPU burst ends first;
+ * arrivals and processes returning from I/O during a quantum are queued
+ * ahead of the preempted process
+ * @param quantum Time slice given to each process
+ */
+static void simulate_round_robin_events(Simulator* sim, int quantum) {
+    SimTime current_time = 0;    // Simulation time
+    int preempted_process = -1;  // Process whose quantum expired at the end of the last slice
+    int woken;                   // Process whose I/O burst has completed
+    RunQueue ready;              // Ready queue in dispatch order
+    queue_init(&ready, sim->num_processes);
+    begin_event_run(sim, &current_time, &preempted_process, &ready, NULL);
+
+    while (sim->completed_count < sim->num_processes) {
+        if (sim->polled && event_loop_poll(sim, current_time, preempted_process, &ready, NULL)) {
+            break;
+        }
+        int first_arrival = sim->next_arrival;
+        admit_arrivals(sim, current_time);
+        for (int i = first_arrival; i < sim->next_arrival; i++) {
+            queue_push(&ready, i);
+        }
+        while ((woken = wake_process(sim, current_time)) >= 0) {
+            queue_push(&ready, woken);
+        }
+        if (preempted_process >= 0) {
+            queue_push(&ready, preempted_process);
+            preempted_process = -1;
+        }
+
+        if (ready.size == 0) {
+            // Nothing is ready: jump to the next arrival or I/O completion
+            current_time = next_ready_time(sim);
+            continue;
+        }
+
+        int index = queue_pop(&ready);
+        Process* p = &sim->processes[index];
+        SimTime slice = p->remaining_time < quantum ? p->remaining_time : quantum;
+        run_segment(sim, p, current_time, current_time + slice);
+        current_time += slice;
+
+        if (p->remaining_time == 0) {
+            end_burst(sim, p, current_time);
+        } else {
+            preempted_process = index;
+        }
+    }
+    queue_free(&ready);
+    finish_accounting(sim);
+}
+
+/**
+ * Simulates a multi-level feedback queue with the event engine
+ * Arrivals, and processes returning from I/O, enter the highest level. A
+ * process that uses its whole quantum drops one level; one preempted by an
+ * arrival at a higher level keeps its
+ * level and rejoins the tail of its queue. Every boost period all processes
+ * return to the highest level. The next level to serve is the lowest set bit
+ * of a bitmap of non-empty levels, so dispatch is O(1) in the number of levels
+ */
+static void simulate_mlfq_events(Simulator* sim) {
+    SimTime current_time = 0;    // Simulation time
+    int preempted_process = -1;  // Process that stopped with time left at the end of the last slice
+    int woken;                   // Process whose I/O burst has completed
+    int last_level = sim->mlfq_levels - 1;
+    SimTime next_boost = sim->mlfq_boost_period > 0 ? sim->mlfq_boost_period : SIM_TIME_MAX;
+    uint64_t nonempty = 0;       // Bit l is set when level l has queued processes
+    RunQueue levels[MLFQ_MAX_LEVELS];
+    int* level = malloc((size_t)(sim->num_processes > 0 ? sim->num_processes : 1) * sizeof(int));
+    if (!level) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    for (int l = 0; l < sim->mlfq_levels; l++) {
+        queue_init(&levels[l], l == 0 ? sim->num_processes : 0);
+    }
+    reset_accounting(sim);
+
+    while (sim->completed_count < sim->num_processes) {
+        int first_arrival = sim->next_arrival;
+        admit_arrivals(sim, current_time);
+        for (int i = first_arrival; i < sim->next_arrival; i++) {
+            level[i] = 0;
+            queue_push(&levels[0], i);
+            nonempty |= 1;
+        }
+        while ((woken = wake_process(sim, current_time)) >= 0) {
+            level[woken] = 0;
+            queue_push(&levels[0], woken);
+            nonempty |= 1;
+        }
+        if (preempted_process >= 0) {
+            RunQueue* queue = &levels[level[preempted_process]];
+            if (queue->size == queue->capacity) {
+                queue_grow(queue);
+            }
+            queue_push(queue, preempted_process);
+            nonempty |= UINT64_C(1) << level[preempted_process];
+            preempted_process = -1;
+        }
+
+        // Move every queued process to the top level, keeping their order
+        if (current_time >= next_boost) {
+            for (int l = 1; l <= last_level; l++) {
+                while (levels[l].size > 0) {
+                    int index = queue_pop(&levels[l]);
+                    level[index] = 0;
+                    queue_push(&levels[0], index);
+                }
+            }
+            nonempty = levels[0].size > 0 ? 1 : 0;
+            while (next_boost <= current_time) {
+                next_boost += sim->mlfq_boost_period;
+            }
+        }
+
+        if (nonempty == 0) {
+            // Nothing is ready: jump to the next arrival or I/O completion
+            current_time = next_ready_time(sim);
+            continue;
+        }
+
+        int l = __builtin_ctzll(nonempty);
+        int index = queue_pop(&levels[l]);
+        if (levels[l].size == 0) {
+            nonempty &= ~(UINT64_C(1) << l);
+        }
+        Process* p = &sim->processes[index];
+
+        // Run one quantum, cut short by the end of the burst, a boost, or a
+        // process entering the top level, which outranks this one
+        int quantum = sim->mlfq_quanta[l];
+        SimTime end = current_time + (p->remaining_time < quantum ? p->remaining_time : quantum);
+        if (l > 0 && next_ready_time(sim) < end) {
+            end = next_ready_time(sim);
+        }
+        if (next_boost < end) {
+            end = next_boost;
+        }
+        bool full_quantum = end - current_time == quantum;
+        run_segment(sim, p, current_time, end);
+        current_time = end;
+
+        if (p->remaining_time == 0) {
+            end_burst(sim, p, current_time);
+        } else {
+            if (full_quantum && l < last_level) {
+                level[index] = l + 1;
+            }
+            preempted_process = index;
+        }
+    }
+
+    for (int l = 0; l < sim->mlfq_levels; l++) {
+        queue_free(&levels[l]);
+    }
+    free(level);
+    finish_accounting(sim);
+}
+
+/**
+ * Simulates a CFS-style fair scheduler with the event engine
+ * Runnable processes wait in a red-black tree ordered by virtual runtime,
+ * which grows with execution inversely to the process's weight. The process
+ * with the smallest virtual runtime runs for its share of the scheduling
+ * period: the latency, stretched to the minimum granularity per runnable
+ * process when there are many, split in proportion to the weights of their
+ * priorities. Arrivals start at the smallest virtual runtime seen so far, and
+ * processes returning from I/O are raised to it; neither preempts the
+ * running process before its slice ends
+ */
+static void simulate_cfs_events(Simulator* sim) {
+    SimTime current_time = 0;    // Simulation time
+    int preempted_process = -1;  // Process whose slice ended with time left
+    int64_t min_vruntime = 0;    // Monotonic floor of the virtual runtimes
+    int64_t total_weight = 0;    // Weight of all runnable processes, including the running one
+    int woken;                   // Process whose I/O burst has completed
+    VruntimeTree tree;
+    tree_init(&tree, sim->num_processes, sim->processes);
+    reset_accounting(sim);
+
+    while (sim->completed_count < sim->num_processes) {
+        int first_arrival = sim->next_arrival;
+        admit_arrivals(sim, current_time);
+        for (int i = first_arrival; i < sim->next_arrival; i++) {
+            tree.nodes[i].vruntime = min_vruntime;
+            tree_insert(&tree, i);
+            total_weight += priority_weight(sim->processes[i].priority);
+        }
+        while ((woken = wake_process(sim, current_time)) >= 0) {
+            if (tree.nodes[woken].vruntime < min_vruntime) {
+                tree.nodes[woken].vruntime = min_vruntime;
+            }
+            tree_insert(&tree, woken);
+            total_weight += priority_weight(sim->processes[woken].priority);
+        }
+        if (preempted_process >= 0) {
+            tree_insert(&tree, preempted_process);
+            preempted_process = -1;
+        }
+
+        if (tree.leftmost == tree.nil) {
+            // Nothing is ready: jump to the next arrival or I/O completion
+            current_time = next_ready_time(sim);
+            continue;
+        }
+
+        int index = tree.leftmost;
+        tree_remove(&tree, index);
+        Process* p = &sim->processes[index];
+        int weight = priority_weight(p->priority);
+        if (tree.nodes[index].vruntime > min_vruntime) {
+            min_vruntime = tree.nodes[index].vruntime;
+        }
+
+        // Share of the scheduling period in proportion to weight
+        int64_t runnable = tree.size + 1;
+        int64_t period = sim->cfs_latency;
+        if (period < runnable * sim->cfs_min_granularity) {
+            period = runnable * sim->cfs_min_granularity;
+        }
+        int64_t slice = period * weight / total_weight;
+        if (slice < 1) {
+            slice = 1;
+        }
+        if (slice > p->remaining_time) {
+            slice = p->remaining_time;
+        }
+
+        run_segment(sim, p, current_time, current_time + (SimTime)slice);
+        current_time += (SimTime)slice;
+        tree.nodes[index].vruntime += (slice * NICE_0_WEIGHT << CFS_VRUNTIME_SHIFT) / weight;
+
+        if (p->remaining_time == 0) {
+            total_weight -= weight;
+            end_burst(sim, p, current_time);
+        } else {
+            preempted_process = index;
+        }
+    }
+    tree_free(&tree);
+    finish_accounting(sim);
+}
+
+/**
+ * Simulates a policy on several cores with the event engine
+ * Each core has its own ready queue; arriving processes join the core with
+ * the fewest processes, and with work stealing an idle core takes the next
+ * waiting process of the most loaded core, paying the migration cost before
+ * it executes. Processes never move between cores otherwise
+ * @param policy Scheduling policy applied on every core
+ * @param quantum Time slice for Round Robin
+ */
+static void simulate_multicore(Simulator* sim, Policy policy, int quantum) {
+    SimTime current_time = 0; // Simulation time
+    int slice = policy == POLICY_RR ? quantum : 0; // Longest segment, 0 for run to completion
+    int woken;               // Process whose I/O burst has completed
+    Core* cores = calloc(sim->num_cores, sizeof(Core));
+    if (!cores) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    for (int c = 0; c < sim->num_cores; c++) {
+        cores[c].running = -1;
+        cores[c].preempted = -1;
+#ifdef SCHEDULER_STATS
+        cores[c].tracker.id = -1;
+#endif
+        heap_init(&cores[c].heap, 0, sim->processes);
+        queue_init(&cores[c].queue, 0);
+    }
+    reset_accounting(sim);
+
+    while (sim->completed_count < sim->num_processes) {
+        // Close the segments that end now
+        for (int c = 0; c < sim->num_cores; c++) {
+            Core* core = &cores[c];
+            if (core->running >= 0 && core->end == current_time) {
+                int index = core->running;
+                core_stop(sim, c, core, current_time);
+                if (sim->processes[index].remaining_time == 0) {
+                    if (policy == POLICY_SJF) {
+                        heap_pop(&core->heap);
+                    }
+                    end_burst(sim, &sim->processes[index], current_time);
+                } else {
+                    core->preempted = index;
+                }
+            }
+        }
+
+        // Place arrivals and processes returning from I/O on the least loaded
+        // core, then requeue expired quanta; SJF compares them with the
+        // up-to-date remaining time of the running processes
+        if (policy == POLICY_SJF) {
+            for (int c = 0; c < sim->num_cores; c++) {
+                core_sync(sim, &cores[c], current_time);
+            }
+        }
+        int first_arrival = sim->next_arrival;
+        admit_arrivals(sim, current_time);
+        for (int i = first_arrival; i < sim->next_arrival; i++) {
+            core_enqueue(&cores[least_loaded_core(sim, cores, policy)], policy, i);
+        }
+        while ((woken = wake_process(sim, current_time)) >= 0) {
+            core_enqueue(&cores[least_loaded_core(sim, cores, policy)], policy, woken);
+        }
+        for (int c = 0; c < sim->num_cores; c++) {
+            if (cores[c].preempted >= 0) {
+                core_enqueue(&cores[c], policy, cores[c].preempted);
+                cores[c].preempted = -1;
+            }
+        }
+
+        for (int c = 0; c < sim->num_cores; c++) {
+            Core* core = &cores[c];
+
+            // A shorter arrival preempts the running process, which stays queued
+            if (policy == POLICY_SJF && core->running >= 0 && core->heap.items[0] != core->running) {
+                core_stop(sim, c, core, current_time);
+            }
+            if (core->running >= 0) {
+                continue;
+            }
+
+            if (core_waiting(core, policy) > 0) {
+                int index = policy == POLICY_SJF ? core->heap.items[0] : queue_pop(&core->queue);
+                core_dispatch(sim, c, core, index, current_time, 0, slice);
+            } else if (sim->work_stealing) {
+                // Steal from the core with the most waiting processes
+                int victim = -1;
+                int most_waiting = 0;
+                for (int v = 0; v < sim->num_cores; v++) {
+                    int waiting = core_waiting(&cores[v], policy);
+                    if (waiting > most_waiting) {
+                        victim = v;
+                        most_waiting = waiting;
+                    }
+                }
+                if (victim >= 0) {
+                    int index = core_steal(&cores[victim], policy);
+                    if (policy == POLICY_SJF) {
+                        core_enqueue(core, policy, index);
+                    }
+                    sim->core_stats[c].steals++;
+                    core_dispatch(sim, c, core, index, current_time, sim->migration_cost, slice);
+                }
+            }
+        }
+
+        // Advance to the next segment end, arrival or I/O completion
+        SimTime next_time = next_ready_time(sim);
+        for (int c = 0; c < sim->num_cores; c++) {
+            if (cores[c].running >= 0 && cores[c].end < next_time) {
+                next_time = cores[c].end;
+            }
+        }
+        current_time = next_time;
+    }
+
+    for (int c = 0; c < sim->num_cores; c++) {
+        heap_free(&cores[c].heap);
+        queue_free(&cores[c].queue);
+    }
+    free(cores);
+    finish_accounting(sim);
+}
+
+/**
+ * Picks the core a newly ready process joins
+ * @param cores Cores of the simulation
+ * @param policy Scheduling policy of the simulation
+ * @return Index of the core with the fewest waiting and running processes,
+ *         the lowest index on ties
+ */
+static int least_loaded_core(const Simulator* sim, const Core* cores, Policy policy) {
+    int target = 0;
+    int target_load = INT_MAX;
+    for (int c = 0; c < sim->num_cores; c++) {
+        int load = core_waiting(&cores[c], policy) + (cores[c].running >= 0 ? 1 : 0);
+        if (load < target_load) {
+            target = c;
+            target_load = load;
+        }
+    }
+    return target;
+}
+
+/**
+ * Counts the processes waiting in a core's ready queue
+ * @param core Core to inspect
+ * @param policy Scheduling policy of the simulation
+ * @return Queued processes, not counting the running one
+ */
+static int core_waiting(const Core* core, Policy policy) {
+    if (policy == POLICY_SJF) {
+        return core->heap.size - (core->running >= 0 ? 1 : 0);
+    }
+    return core->queue.size;
+}
+
+/**
+ * Adds a process to a core's ready queue, growing it when full
+ * @param core Core to queue on
+ * @param policy Scheduling policy of the simulation
+ * @param index Index of the process in the process table
+ */
+static void core_enqueue(Core* core, Policy policy, int index) {
+    if (policy == POLICY_SJF) {
+        if (core->heap.size == core->heap.capacity) {
+            heap_grow(&core->heap);
+        }
+        heap_push(&core->heap, index);
+    } else {
+        if (core->queue.size == core->queue.capacity) {
+            queue_grow(&core->queue);
+        }
+        queue_push(&core->queue, index);
+    }
+}
+
+/**
+ * Removes the process a core would dispatch next from its ready queue
+ * For SJF this is the shortest waiting process, which is below the running
+ * one when the core is busy
+ * @param core Core to take from (must have a waiting process)
+ * @param policy Scheduling policy of the simulation
+ * @return Index of the removed process
+ */
+static int core_steal(Core* core, Policy policy) {
+    if (policy != POLICY_SJF) {
+        return queue_pop(&core->queue);
+    }
+    if (core->running < 0) {
+        return heap_pop(&core->heap);
+    }
+    int running = heap_pop(&core->heap);
+    int index = heap_pop(&core->heap);
+    heap_push(&core->heap, running);
+    return index;
+}
+
+/**
+ * Brings the remaining time of the process running on a core up to date
+ * @param core Core to update, may be idle
+ * @param current_time Current simulation time
+ */
+static void core_sync(Simulator* sim, const Core* core, SimTime current_time) {
+    if (core->running >= 0 && current_time > core->exec_start) {
+        sim->processes[core->running].remaining_time = core->start_remaining - (current_time - core->exec_start);
+    }
+}
+
+/**
+ * Ends the segment running on a core at the given time
+ * Time before the process started executing is counted as migration
+ * @param c Index of the core
+ * @param core Core to stop
+ * @param current_time Time the segment ends
+ */
+static void core_stop(Simulator* sim, int c, Core* core, SimTime current_time) {
+    Process* p = &sim->processes[core->running];
+    SimTime exec_start = core->exec_start < current_time ? core->exec_start : current_time;
+
+    sim->core_stats[c].migration_time += exec_start - core->dispatch_time;
+    if (current_time > exec_start) {
+        core_sync(sim, core, current_time);
+        if (p->start_time < 0) {
+            p->start_time = exec_start;
+        }
+        if (sim->trace_level >= TRACE_SEGMENTS) {
+            // C<core> T<start>-T<last> : P<id> - ..., one line per segment at either level
+            TraceSegment* segment = &sim->pending_segment;
+            segment->active = true;
+            segment->start = exec_start;
+            segment->last = current_time - 1;
+            segment->id = p->id;
+            segment->remaining_time = core->start_remaining;
+            segment->turnaround_time = exec_start - p->arrival_time;
+            segment->wait_time = segment->turnaround_time - (p->burst_time - core->start_remaining - p->pending_time) - p->blocked_time;
+            output_text(&sim->output, "C");
+            output_int(&sim->output, c, 0);
+            output_text(&sim->output, " ");
+            print_pending_segment(sim);
+        }
+        sim->core_stats[c].busy_time += current_time - exec_start;
+        sim->segments++;
+        STATS_ADD(sim, events, 1);
+        STATS_RUN(sim, &core->tracker, p);
+    }
+    core->running = -1;
+}
+
+/**
+ * Starts executing a process on an idle core
+ * @param c Index of the core
+ * @param core Core to dispatch
+ * @param index Index of the process in the process table, already queued on the core for SJF
+ * @param current_time Current simulation time
+ * @param delay Time units before the process executes
+ * @param quantum Time slice for Round Robin (0 runs the process to completion)
+ */
+static void core_dispatch(Simulator* sim, int c, Core* core, int index, SimTime current_time, int delay, int quantum) {
+    const Process* p = &sim->processes[index];
+    SimTime slice = p->remaining_time;
+    if (quantum > 0 && quantum < slice) {
+        slice = quantum;
+    }
+    core->running = index;
+    core->dispatch_time = current_time;
+    core->exec_start = current_time + delay;
+    core->end = core->exec_start + slice;
+    core->start_remaining = p->remaining_time;
+    sim->core_stats[c].dispatches++;
+}
+
+/**
+ * Runs a process without interruption over [start, end)
+ * Emits the same trace as the tick engine; during a segment the wait time
+ * stays constant and the turnaround time grows with the clock
+ * @param p Process being executed
+ * @param start First time unit of the segment
+ * @param end Time unit after the last one of the segment
+ */
+static void run_segment(Simulator* sim, Process* p, SimTime start, SimTime end) {
+    if (p->start_time < 0) {
+        p->start_time = start;
+    }
+
+    if (trace_enabled(sim)) {
+        // Time spent waiting before this segment: elapsed time minus time
+        // already executed or blocked on I/O
+        SimTime turnaround_time = start - p->arrival_time;
+        SimTime wait_time = turnaround_time - (p->burst_time - p->remaining_time - p->pending_time) - p->blocked_time;
+        trace_segment(sim, start, end, p->id, p->remaining_time, wait_time, turnaround_time);
+    }
+    p->remaining_time -= end - start;
+    sim->segments++;
+    STATS_ADD(sim, events, 1);
+    STATS_RUN(sim, &sim->tracker, p);
+}
+
+/**
+ * Marks a process as completed
+ * With incremental accounting its statistics are derived from its timestamps;
+ * the final time unit does not count towards turnaround, as in the scan
+ * @param p Process that has finished execution
+ * @param completion_time Time unit after the last one the process executed
+ */
+static void complete_process(Simulator* sim, Process* p, SimTime completion_time) {
+    p->completed = true;
+    p->completion_time = completion_time;
+    sim->ready_count--;
+    sim->completed_count++;
+
+    if (sim->layout == LAYOUT_SOA) {
+        int i = (int)(p - sim->processes);
+        sim->columns.completed[i / 64] |= UINT64_C(1) << (i % 64);
+    }
+
+    // The timestamps give the times every accounting mode arrives at
+    SimTime wait_time = completion_time - p->arrival_time - p->burst_time - p->io_time;
+    SimTime turnaround_time = completion_time - p->arrival_time - 1;
+    sketch_add(&sim->sketches[METRIC_WAIT], wait_time);
+    sketch_add(&sim->sketches[METRIC_TURNAROUND], turnaround_time);
+    sketch_add(&sim->sketches[METRIC_RESPONSE], p->start_time - p->arrival_time);
+
+    if (sim->accounting == ACCOUNTING_INCREMENTAL) {
+        p->wait_time = wait_time;
+        p->turnaround_time = turnaround_time;
+    }
+}
+
+/**
+ * Ends the current CPU burst of a process
+ * With I/O bursts left, the process blocks until the next one completes and
+ * the CPU burst after it becomes current; otherwise it completes
+ * @param p Process whose burst just ran out
+ * @param end_time Time unit after the last one of the burst
+ * @return true if the process completed, false if it blocked
+ */
+static bool end_burst(Simulator* sim, Process* p, SimTime end_time) {
+    if (p->phase == p->num_phases) {
+        complete_process(sim, p, end_time);
+        return true;
+    }
+
+    const SimTime* phase = &sim->phases[p->first_phase + 2 * p->phase];
+    p->phase++;
+    p->blocked_time += phase[0];
+    p->remaining_time = phase[1];
+    p->pending_time -= phase[1];
+    sim->ready_count--;
+    blocked_push(&sim->blocked, end_time + phase[0], (int)(p - sim->processes));
+    return false;
+}
+
+/**
+ * Takes the next process whose I/O burst has completed by the given time
+ * Processes due at the same time come out in arrival order
+ * @param current_time Current simulation time
+ * @return Index of the process, or -1 once no more are due
+ */
+static int wake_process(Simulator* sim, SimTime current_time) {
+    if (sim->blocked.size == 0 || sim->blocked.items[0].wake_time > current_time) {
+        return -1;
+    }
+    sim->ready_count++;
+    STATS_ADD(sim, events, 1);
+    STATS_READY(sim);
+    return blocked_pop(&sim->blocked);
+}
+
+/**
+ * Finds when the next process becomes ready
+ * @return Time of the next arrival or I/O completion, SIM_TIME_MAX if there is none
+ */
+static SimTime next_ready_time(const Simulator* sim) {
+    SimTime next = SIM_TIME_MAX;
+    if (sim->next_arrival < sim->num_processes) {
+        next = sim->processes[sim->next_arrival].arrival_time;
+    }
+    if (sim->blocked.size > 0 && sim->blocked.items[0].wake_time < next) {
+        next = sim->blocked.items[0].wake_time;
+    }
+    return next;
+}
+
+/**
+ * Sorts the process table by arrival time, ties in ID order, unless it
+ * already is
+ */
+static void sort_by_arrival(Simulator* sim) {
+    for (int i = 1; i < sim->num_processes; i++) {
+        if (compare_arrivals(&sim->processes[i - 1], &sim->processes[i]) > 0) {
+            qsort(sim->processes, sim->num_processes, sizeof(Process), compare_arrivals);
+            return;
+        }
+    }
+}
+
+/**
+ * Orders (partition, index) pairs by partition, then by index
+ * @param a First pair
+ * @param b Second pair
+ * @return Negative, zero or positive as a sorts before, with or after b
+ */
+static int compare_partitions(const void* a, const void* b) {
+    const int* p = a;
+    const int* q = b;
+    if (p[0] != q[0]) {
+        return p[0] < q[0] ? -1 : 1;
+    }
+    return (p[1] > q[1]) - (p[1] < q[1]);
+}
+
+/**
+ * Orders shards by decreasing number of processes, then by position
+ * @param a First shard
+ * @param b Second shard
+ * @return Negative, zero or positive as a sorts before, with or after b
+ */
+static int compare_shard_sizes(const void* a, const void* b) {
+    const Shard* p = a;
+    const Shard* q = b;
+    if (p->count != q->count) {
+        return p->count > q->count ? -1 : 1;
+    }
+    return (p->first > q->first) - (p->first < q->first);
+}
+
+/**
+ * Orders processes by arrival time, then by ID
+ * @param a First process
+ * @param b Second process
+ * @return Negative, zero or positive as a arrives before, with or after b
+ */
+static int compare_arrivals(const void* a, const void* b) {
+    const Process* p = a;
+    const Process* q = b;
+    if (p->arrival_time != q->arrival_time) {
+        return p->arrival_time < q->arrival_time ? -1 : 1;
+    }
+    return (p->id > q->id) - (p->id < q->id);
+}
+
+/**
+ * Looks up the CFS weight of a priority
+ * Uses the weights of the Linux scheduler, where each nice level changes the
+ * share of the processor by about 25%
+ * @param priority Nice value, clamped to PRIORITY_HIGHEST..PRIORITY_LOWEST
+ * @return Weight, NICE_0_WEIGHT at priority 0
+ */
+static int priority_weight(int priority) {
+    static const int weights[PRIORITY_LOWEST - PRIORITY_HIGHEST + 1] = {
+        88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916,
+        9548, 7620, 6100, 4904, 3906, 3121, 2501, 1991, 1586, 1277,
+        1024, 820, 655, 526, 423, 335, 272, 215, 172, 137,
+        110, 87, 70, 56, 45, 36, 29, 23, 18, 15
+    };
+    if (priority < PRIORITY_HIGHEST) {
+        priority = PRIORITY_HIGHEST;
+    } else if (priority > PRIORITY_LOWEST) {
+        priority = PRIORITY_LOWEST;
+    }
+    return weights[priority - PRIORITY_HIGHEST];
+}
+
+/**
+ * Reads the clock that phase timings and checkpoint intervals are taken with
+ * @return Seconds on a monotonic clock
+ */
+static double monotonic_clock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+#ifdef SCHEDULER_STATS
+/**
+ * Records that a processor ran a process; a run of a different process than
+ * the last one is a context switch, and a preemption when the last one stopped
+ * with its CPU burst unfinished
+ * @param stats Counters to update
+ * @param tracker Process the processor ran last
+ * @param p Process that ran, with its remaining time after the run
+ */
+static void stats_run(SimulatorStats* stats, SwitchTracker* tracker, const Process* p) {
+    if (p->id != tracker->id) {
+        stats->context_switches++;
+        if (tracker->id >= 0 && tracker->cut) {
+            stats->preemptions++;
+        }
+        tracker->id = p->id;
+    }
+    tracker->cut = p->remaining_time > 0;
+}
+
+/**
+ * Adds the counters of one run to those of others; the ready high-water
+ * mark becomes the larger of the two, and the phase timings are left alone
+ * @param stats Counters to update
+ * @param other Counters to add
+ */
+static void stats_merge(SimulatorStats* stats, const SimulatorStats* other) {
+    stats->context_switches += other->context_switches;
+    stats->preemptions += other->preemptions;
+    if (other->max_ready > stats->max_ready) {
+        stats->max_ready = other->max_ready;
+    }
+    stats->scan_iterations += other->scan_iterations;
+    stats->ticks += other->ticks;
+    stats->events += other->events;
+    stats->shard_steals += other->shard_steals;
+}
+#endif
+
+/**
+ * Finds the sketch bucket of a time: the time itself below SKETCH_SUB_BUCKETS,
+ * otherwise its power of two and its top bits below the leading one
+ * @param value Non-negative time
+ * @return Index of the bucket
+ */
+static int sketch_bucket(SimTime value) {
+    if (value < SKETCH_SUB_BUCKETS) {
+        return (int)value;
+    }
+    int exponent = 63 - __builtin_clzll((unsigned long long)value);    // At least 7
+    int shift = exponent - 6;
+    return SKETCH_SUB_BUCKETS + (exponent - 7) * (SKETCH_SUB_BUCKETS / 2) + (int)((value >> shift) - SKETCH_SUB_BUCKETS / 2);
+}
+
+/**
+ * Gives the time a sketch bucket stands for, the middle of its range
+ * @param bucket Index of the bucket
+ * @return Representative time
+ */
+static SimTime sketch_value(int bucket) {
+    if (bucket < SKETCH_SUB_BUCKETS) {
+        return bucket;
+    }
+    int exponent = 7 + (bucket - SKETCH_SUB_BUCKETS) / (SKETCH_SUB_BUCKETS / 2);
+    int shift = exponent - 6;
+    int mantissa = SKETCH_SUB_BUCKETS / 2 + (bucket - SKETCH_SUB_BUCKETS) % (SKETCH_SUB_BUCKETS / 2);
+    return (SimTime)(((int64_t)mantissa << shift) + (INT64_C(1) << (shift - 1)));
+}
+
+/**
+ * Records a time in a sketch
+ * @param sketch Sketch to update
+ * @param value Time to record; negative times count as 0
+ */
+static void sketch_add(LatencySketch* sketch, SimTime value) {
+    if (value < 0) {
+        value = 0;
+    }
+    sketch->counts[sketch_bucket(value)]++;
+    sketch->total++;
+    if (value > sketch->max) {
+        sketch->max = value;
+    }
+}
+
+/**
+ * Adds the times recorded in one sketch to another
+ * @param sketch Sketch to update
+ * @param other Sketch to add
+ */
+static void sketch_merge(LatencySketch* sketch, const LatencySketch* other) {
+    for (int b = 0; b < SKETCH_BUCKETS; b++) {
+        sketch->counts[b] += other->counts[b];
+    }
+    sketch->total += other->total;
+    if (other->max > sketch->max) {
+        sketch->max = other->max;
+    }
+}
+
+/**
+ * Resets the running counts before a simulation starts
+ */
+static void reset_accounting(Simulator* sim) {
+    sim->ready_count = 0;
+    sim->completed_count = 0;
+    sim->next_arrival = 0;
+    sim->segments = 0;
+    sim->blocked.size = 0;
+    memset(sim->sketches, 0, sizeof(sim->sketches));
+#ifdef SCHEDULER_STATS
+    // Loading happens before the run, so its time is kept
+    double load_seconds = sim->stats.load_seconds;
+    memset(&sim->stats, 0, sizeof(sim->stats));
+    sim->stats.load_seconds = load_seconds;
+    sim->tracker.id = -1;
+#endif
+
+    if (sim->layout == LAYOUT_SOA) {
+        load_columns(sim);
+    }
+}
+
+/**
+ * Starts the loop of an event-engine run: from the beginning, or from where
+ * a checkpoint left off when the run is being resumed
+ * @param current_time Set to the time the loop starts at
+ * @param preempted Set to the Round Robin process to requeue first, or NULL for other policies
+ * @param queue Ready queue to restore into, or NULL
+ * @param heap Ready heap to restore into, or NULL
+ */
+static void begin_event_run(Simulator* sim, SimTime* current_time, int* preempted, RunQueue* queue, ProcessHeap* heap) {
+    const ResumeState* resume = sim->resume;
+    if (resume == NULL) {
+        reset_accounting(sim);
+        return;
+    }
+
+    // Pushing in stored order keeps both the queue order and the heap shape
+    for (int i = 0; i < resume->ready_size; i++) {
+        if (queue != NULL) {
+            queue_push(queue, resume->ready[i]);
+        } else {
+            heap_push(heap, resume->ready[i]);
+        }
+    }
+    *current_time = resume->current_time;
+    if (preempted != NULL) {
+        *preempted = resume->preempted;
+    }
+    sim->resume = NULL;
+}
+
+/**
+ * Completes the trace and hands the results of the sweeps back to the
+ * process table after a simulation
+ */
+static void finish_accounting(Simulator* sim) {
+    trace_finish(sim);
+    if (sim->layout == LAYOUT_SOA) {
+        for (int i = 0; i < sim->num_processes; i++) {
+            sim->processes[i].wait_time = sim->columns.wait_time[i];
+            sim->processes[i].turnaround_time = sim->columns.turnaround_time[i];
+        }
+        free_columns(sim);
+    }
+}
+
+/**
+ * Executes a process for the time unit starting at current_time
+ * @param mode Accounting mode of the tick-engine variant
+ * @param p Process to execute
+ * @param current_time Current simulation time
+ */
+static TICK_INLINE void execute_time_unit(Simulator* sim, TickMode mode, Process* p, SimTime current_time) {
+    if (p->start_time < 0) {
+        p->start_time = current_time;
+    }
+
+    // Decrease remaining time, keeping the sweep column in step
+    p->remaining_time--;
+    if (mode == TICK_SCAN_SOA) {
+        sim->columns.remaining_time[p - sim->processes] = p->remaining_time;
+    }
+    STATS_RUN(sim, &sim->tracker, p);
+
+    // If process has finished execution
+    if (p->remaining_time == 0) {
+        complete_process(sim, p, current_time + 1);
+    }
+}
+
+/**
+ * Moves every process that has arrived by the given time into the ready count
+ * Processes are stored in arrival order, so this is amortized O(1) per time unit
+ * @param current_time Current simulation time
+ */
+static void admit_arrivals(Simulator* sim, SimTime current_time) {
+    while (sim->next_arrival < sim->num_processes && sim->processes[sim->next_arrival].arrival_time <= current_time) {
+        sim->ready_count++;
+        sim->next_arrival++;
+        STATS_ADD(sim, events, 1);
+    }
+    STATS_READY(sim);
+}
+
+/**
+ * Updates wait and turnaround times at the end of a time unit
+ * Only the scan mode touches every process; incremental accounting does the
+ * work once per process in complete_process()
+ * @param mode Accounting mode of the tick-engine variant
+ * @param current_time Current simulation time
+ * @param active_process_id ID of the process that executed (-1 if none)
+ */
+static TICK_INLINE void update_times(Simulator* sim, TickMode mode, SimTime current_time, int active_process_id) {
+    STATS_ADD(sim, ticks, 1);
+    if (mode == TICK_INCREMENTAL) {
+        return;
+    }
+    if (mode == TICK_SCAN_SOA) {
+        sim->kernels->update_wait(sim, current_time, active_process_id);
+        sim->kernels->update_turnaround(sim, current_time);
+    } else {
+        update_wait_times(sim, current_time, active_process_id);
+        update_turnaround_times(sim, current_time);
+    }
+}
+
+/**
+ * Prints the trace line for the process executing at the given time
+ * With incremental accounting the live wait and turnaround times are derived
+ * from the clock: everything since arrival not spent executing was waiting
+ * @param mode Accounting mode of the tick-engine variant
+ * @param current_time Current simulation time
+ * @param p Process about to execute for one time unit
+ */
+static TICK_INLINE void print_tick(Simulator* sim, TickMode mode, SimTime current_time, const Process* p) {
+    SimTime wait_time = p->wait_time;
+    SimTime turnaround_time = p->turnaround_time;
+
+    if (mode == TICK_INCREMENTAL) {
+        turnaround_time = current_time - p->arrival_time;
+        wait_time = turnaround_time - (p->burst_time - p->remaining_time - p->pending_time) - p->blocked_time;
+    } else if (mode == TICK_SCAN_SOA) {
+        wait_time = sim->columns.wait_time[p - sim->processes];
+        turnaround_time = sim->columns.turnaround_time[p - sim->processes];
+    }
+
+    trace_segment(sim, current_time, current_time + 1, p->id, p->remaining_time, wait_time, turnaround_time);
+}
+
+/**
+ * Checks whether executed segments need to be reported at all
+ * @return true if a text or binary trace is being produced
+ */
+static bool trace_enabled(Simulator* sim) {
+    return sim->trace_level >= TRACE_SEGMENTS || sim->binary_trace.file != NULL;
+}
+
+/**
+ * Prints the full trace line for one time unit
+ * @param current_time Current simulation time
+ * @param id Process ID
+ * @param remaining_time Remaining CPU time before this time unit
+ * @param wait_time Wait time so far
+ * @param turnaround_time Turnaround time so far
+ */
+static void trace_line(Simulator* sim, SimTime current_time, int id, SimTime remaining_time, SimTime wait_time, SimTime turnaround_time) {
+    // T<time> : P<id> - Burst left <remaining>, Wait time <wait>, Turnaround time <turnaround>
+    output_text(&sim->output, "T");
+    output_int(&sim->output, current_time, 0);
+    output_text(&sim->output, " : P");
+    output_int(&sim->output, id, 0);
+    output_text(&sim->output, " - Burst left ");
+    output_int(&sim->output, remaining_time, 2);
+    output_text(&sim->output, ", Wait time ");
+    output_int(&sim->output, wait_time, 0);
+    output_text(&sim->output, ", Turnaround time ");
+    output_int(&sim->output, turnaround_time, 0);
+    output_text(&sim->output, "\n");
+}
+
+/**
+ * Records that a process executes over [start, end)
+ * TRACE_FULL expands the segment into one line per time unit; TRACE_SEGMENTS
+ * merges it with the pending segment when it continues the same process.
+ * The binary trace, if open, receives every segment regardless of the level
+ * @param start First time unit of the segment
+ * @param end Time unit after the last one of the segment
+ * @param id Process ID
+ * @param remaining_time Remaining CPU time at the start of the segment
+ * @param wait_time Wait time at the start of the segment
+ * @param turnaround_time Turnaround time at the start of the segment
+ */
+static void trace_segment(Simulator* sim, SimTime start, SimTime end, int id, SimTime remaining_time, SimTime wait_time, SimTime turnaround_time) {
+    if (sim->binary_trace.file != NULL) {
+        binary_trace_segment(sim, start, end, id);
+    }
+
+    if (sim->trace_level == TRACE_FULL) {
+        for (SimTime t = start; t < end; t++) {
+            trace_line(sim, t, id, remaining_time - (t - start), wait_time, turnaround_time + (t - start));
+        }
+        return;
+    }
+    if (sim->trace_level != TRACE_SEGMENTS) {
+        return;
+    }
+
+    if (sim->pending_segment.active && sim->pending_segment.id == id && sim->pending_segment.last + 1 == start) {
+        sim->pending_segment.last = end - 1;
+        return;
+    }
+    print_pending_segment(sim);
+    sim->pending_segment.active = true;
+    sim->pending_segment.start = start;
+    sim->pending_segment.last = end - 1;
+    sim->pending_segment.id = id;
+    sim->pending_segment.remaining_time = remaining_time;
+    sim->pending_segment.wait_time = wait_time;
+    sim->pending_segment.turnaround_time = turnaround_time;
+}
+
+/**
+ * Prints the pending segment, if any
+ */
+static void print_pending_segment(Simulator* sim) {
+    if (sim->pending_segment.active) {
+        // T<start>-T<last> : P<id> - Burst left <remaining>, Wait time <wait>, Turnaround time <turnaround>
+        output_text(&sim->output, "T");
+        output_int(&sim->output, sim->pending_segment.start, 0);
+        output_text(&sim->output, "-T");
+        output_int(&sim->output, sim->pending_segment.last, 0);
+        output_text(&sim->output, " : P");
+        output_int(&sim->output, sim->pending_segment.id, 0);
+        output_text(&sim->output, " - Burst left ");
+        output_int(&sim->output, sim->pending_segment.remaining_time, 2);
+        output_text(&sim->output, ", Wait time ");
+        output_int(&sim->output, sim->pending_segment.wait_time, 0);
+        output_text(&sim->output, ", Turnaround time ");
+        output_int(&sim->output, sim->pending_segment.turnaround_time, 0);
+        output_text(&sim->output, "\n");
+        sim->pending_segment.active = false;
+    }
+}
+
+/**
+ * Prints the pending segment and writes out buffered trace output
+ */
+static void trace_finish(Simulator* sim) {
+    print_pending_segment(sim);
+    output_flush(&sim->output);
+    if (sim->binary_trace.file != NULL) {
+        binary_trace_write_pending(sim);
+        binary_trace_flush(sim);
+    }
+}
+
+/**
+ * Appends an unsigned LEB128 varint to a buffer
+ * @param buffer Buffer with room for at least 10 more bytes
+ * @param value Value to encode
+ * @return Number of bytes written
+ */
+static size_t encode_varint(unsigned char* buffer, uint64_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        buffer[length++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    buffer[length++] = (unsigned char)value;
+    return length;
+}
+
+/**
+ * Decodes an unsigned LEB128 varint
+ * @param data Next byte to decode, advanced past the varint
+ * @param end End of the data
+ * @param value Receives the decoded value
+ * @return false if the data ends inside the varint or the varint is too long
+ */
+static bool decode_varint(const unsigned char** data, const unsigned char* end, uint64_t* value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64 && *data < end; shift += 7) {
+        unsigned char byte = *(*data)++;
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Writes a little-endian integer of the given width
+ * @param buffer Destination
+ * @param value Value to store
+ * @param bytes Number of bytes to store
+ */
+static void store_le(unsigned char* buffer, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        buffer[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+/**
+ * Reads a little-endian integer of the given width
+ * @param buffer Source
+ * @param bytes Number of bytes to read
+ * @return The value read
+ */
+static uint64_t load_le(const unsigned char* buffer, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint64_t)buffer[i] << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * Creates a binary trace file and writes its header
+ * Layout: "SSEG", u32 version, u64 segment count (all little-endian), then
+ * one record per segment of three varints: the gap since the previous
+ * segment's end, the segment length, and the zigzag-encoded change of
+ * process ID
+ * @param filename Name of the file to create
+ * @return false if the file cannot be created
+ */
+bool binary_trace_open(Simulator* sim, const char* filename) {
+    sim->binary_trace.file = fopen(filename, "wb");
+    if (!sim->binary_trace.file) {
+        return false;
+    }
+    sim->binary_trace.count = 0;
+    sim->binary_trace.pending = false;
+    sim->binary_trace.previous_end = 0;
+    sim->binary_trace.previous_id = 0;
+
+    // The segment count is patched in by binary_trace_close()
+    memcpy(sim->binary_trace.buffer, BINARY_TRACE_MAGIC, 4);
+    store_le(sim->binary_trace.buffer + 4, BINARY_TRACE_VERSION, 4);
+    store_le(sim->binary_trace.buffer + 8, 0, 8);
+    sim->binary_trace.length = BINARY_TRACE_HEADER_SIZE;
+    return true;
+}
+
+/**
+ * Adds a segment to the binary trace, merging it with the pending one when
+ * the same process continues without a gap
+ * @param start First time unit of the segment
+ * @param end Time unit after the last one of the segment
+ * @param id Process ID
+ */
+static void binary_trace_segment(Simulator* sim, SimTime start, SimTime end, int id) {
+    if (sim->binary_trace.pending && sim->binary_trace.id == id && sim->binary_trace.end == start) {
+        sim->binary_trace.end = end;
+        return;
+    }
+    binary_trace_write_pending(sim);
+    sim->binary_trace.pending = true;
+    sim->binary_trace.start = start;
+    sim->binary_trace.end = end;
+    sim->binary_trace.id = id;
+}
+
+/**
+ * Encodes the pending segment into the write buffer
+ */
+static void binary_trace_write_pending(Simulator* sim) {
+    if (!sim->binary_trace.pending) {
+        return;
+    }
+    if (sim->binary_trace.length + 30 > BINARY_TRACE_BUFFER_SIZE) {
+        binary_trace_flush(sim);
+    }
+
+    unsigned char* out = sim->binary_trace.buffer + sim->binary_trace.length;
+    int64_t id_delta = (int64_t)sim->binary_trace.id - sim->binary_trace.previous_id;
+    uint64_t zigzag = id_delta < 0 ? ((uint64_t)(-(id_delta + 1)) << 1) | 1 : (uint64_t)id_delta << 1;
+    size_t length = encode_varint(out, (uint64_t)(sim->binary_trace.start - sim->binary_trace.previous_end));
+    length += encode_varint(out + length, (uint64_t)(sim->binary_trace.end - sim->binary_trace.start));
+    length += encode_varint(out + length, zigzag);
+
+    sim->binary_trace.length += length;
+    sim->binary_trace.previous_end = sim->binary_trace.end;
+    sim->binary_trace.previous_id = sim->binary_trace.id;
+    sim->binary_trace.count++;
+    sim->binary_trace.pending = false;
+}
+
+/**
+ * Writes the encoded segments to the binary trace file
+ */
+static void binary_trace_flush(Simulator* sim) {
+    if (sim->binary_trace.length > 0 &&
+        fwrite(sim->binary_trace.buffer, 1, sim->binary_trace.length, sim->binary_trace.file) != sim->binary_trace.length) {
+        printf("Error: Could not write binary trace\n");
+        exit(1);
+    }
+    sim->binary_trace.length = 0;
+}
+
+/**
+ * Completes the binary trace and records the segment count in its header
+ * The count stays 0 when the output cannot seek, e.g. when it is a pipe
+ */
+void binary_trace_close(Simulator* sim) {
+    if (sim->binary_trace.file == NULL) {
+        return;
+    }
+    binary_trace_write_pending(sim);
+    binary_trace_flush(sim);
+
+    unsigned char count[8];
+    store_le(count, sim->binary_trace.count, 8);
+    if (fseek(sim->binary_trace.file, 8, SEEK_SET) == 0) {
+        fwrite(count, 1, sizeof(count), sim->binary_trace.file);
+    }
+    if (fclose(sim->binary_trace.file) != 0) {
+        printf("Error: Could not write binary trace\n");
+        exit(1);
+    }
+    sim->binary_trace.file = NULL;
+}
+
+/**
+ * Prints the segments of a binary trace as text
+ * The file is mapped read-only and decoded in place
+ * @param filename Name of the binary trace file
+ * @return 0 on success, 1 if the file cannot be read or is corrupt
+ */
+int dump_binary_trace(const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        printf("Error: Could not open file %s\n", filename);
+        return 1;
+    }
+    if (info.st_size < BINARY_TRACE_HEADER_SIZE) {
+        printf("Error: %s is not a binary trace\n", filename);
+        close(fd);
+        return 1;
+    }
+
+    const unsigned char* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("Error: Could not map file %s\n", filename);
+        return 1;
+    }
+    const unsigned char* end = data + info.st_size;
+    static OutputBuffer out;    // Too large for the stack
+
+    if (memcmp(data, BINARY_TRACE_MAGIC, 4) != 0 || load_le(data + 4, 4) != BINARY_TRACE_VERSION) {
+        printf("Error: %s is not a binary trace\n", filename);
+        munmap((void*)data, (size_t)info.st_size);
+        return 1;
+    }
+    uint64_t expected = load_le(data + 8, 8);
+
+    // Undo the delta encoding while walking the records
+    const unsigned char* record = data + BINARY_TRACE_HEADER_SIZE;
+    int64_t previous_end = 0;
+    int64_t previous_id = 0;
+    uint64_t count = 0;
+    while (record < end) {
+        uint64_t gap, length, zigzag;
+        if (!decode_varint(&record, end, &gap) || !decode_varint(&record, end, &length) ||
+            !decode_varint(&record, end, &zigzag)) {
+            printf("Error: %s is truncated\n", filename);
+            munmap((void*)data, (size_t)info.st_size);
+            return 1;
+        }
+        int64_t start = previous_end + (int64_t)gap;
+        int64_t id = previous_id + ((zigzag & 1) ? -(int64_t)(zigzag >> 1) - 1 : (int64_t)(zigzag >> 1));
+
+        output_text(&out, "T");
+        output_int(&out, start, 0);
+        output_text(&out, "-T");
+        output_int(&out, start + (int64_t)length - 1, 0);
+        output_text(&out, " : P");
+        output_int(&out, id, 0);
+        output_text(&out, "\n");
+
+        previous_end = start + (int64_t)length;
+        previous_id = id;
+        count++;
+    }
+    output_flush(&out);
+    munmap((void*)data, (size_t)info.st_size);
+
+    if (expected != 0 && expected != count) {
+        printf("Error: %s holds %llu segments but its header records %llu\n",
+            filename, (unsigned long long)count, (unsigned long long)expected);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Makes the next runs write checkpoints to a file periodically, replacing it
+ * each time, so that an interrupted run can be continued by simulator_resume()
+ * @param filename File to write, or NULL to stop checkpointing
+ * @param interval Seconds of wall time between checkpoints
+ */
+void simulator_set_checkpoint(Simulator* sim, const char* filename, double interval) {
+    free(sim->checkpoint.filename);
+    sim->checkpoint.filename = NULL;
+    if (filename != NULL) {
+        sim->checkpoint.filename = malloc(strlen(filename) + 1);
+        if (!sim->checkpoint.filename) {
+            printf("Error: Out of memory\n");
+            exit(1);
+        }
+        strcpy(sim->checkpoint.filename, filename);
+    }
+    sim->checkpoint.interval = interval;
+    sim->checkpoint.written = 0;
+}
+
+/**
+ * Counts the checkpoints written since simulator_set_checkpoint()
+ * @return Number of checkpoints, or -1 if one could not be written; no more
+ * are attempted after a failure
+ */
+int simulator_checkpoints_written(const Simulator* sim) {
+    return sim->checkpoint.written;
+}
+
+/**
+ * Writes a checkpoint if the interval has passed; the clock is only read
+ * every CHECKPOINT_POLL_ITERATIONS calls
+ * @param current_time Simulation time at the top of the event loop
+ * @param preempted Round Robin process to requeue first, -1 if none
+ * @param queue Ready queue, or NULL when the run uses a heap
+ * @param heap Ready heap, or NULL when the run uses a queue
+ */
+static void checkpoint_poll(Simulator* sim, SimTime current_time, int preempted, const RunQueue* queue, const ProcessHeap* heap) {
+    Checkpointing* checkpoint = &sim->checkpoint;
+    if (--checkpoint->countdown > 0 || checkpoint->written < 0) {
+        return;
+    }
+    checkpoint->countdown = CHECKPOINT_POLL_ITERATIONS;
+
+    double now = monotonic_clock();
+    if (now - checkpoint->last_time < checkpoint->interval) {
+        return;
+    }
+    checkpoint->written = write_checkpoint(sim, current_time, preempted, queue, heap) ? checkpoint->written + 1 : -1;
+    checkpoint->last_time = monotonic_clock();
+}
+
+/**
+ * Writes the state of a run at the top of its event loop
+ * The file is written under a temporary name and renamed over the previous
+ * checkpoint, so a crash while writing leaves the previous one intact. The
+ * trace printed so far is flushed first, so the output of a resumed run
+ * continues the output up to the checkpoint
+ * @param current_time Simulation time at the top of the event loop
+ * @param preempted Round Robin process to requeue first, -1 if none
+ * @param queue Ready queue, or NULL when the run uses a heap
+ * @param heap Ready heap, or NULL when the run uses a queue
+ * @return Whether the checkpoint was written
+ */
+static bool write_checkpoint(Simulator* sim, SimTime current_time, int preempted, const RunQueue* queue, const ProcessHeap* heap) {
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, 4);
+    header.version = CHECKPOINT_VERSION;
+    header.process_size = sizeof(Process);
+    header.policy = sim->checkpoint.policy;
+    header.quantum = sim->checkpoint.quantum;
+    header.current_time = current_time;
+    header.preempted = preempted;
+    header.num_processes = sim->num_processes;
+    header.num_phase_entries = sim->num_phase_entries;
+    header.ready_size = queue != NULL ? queue->size : heap->size;
+    header.blocked_size = sim->blocked.size;
+    header.next_arrival = sim->next_arrival;
+    header.ready_count = sim->ready_count;
+    header.completed_count = sim->completed_count;
+    header.tracker_id = -1;
+    header.segments = sim->segments;
+    header.pending_segment = sim->pending_segment;
+#ifdef SCHEDULER_STATS
+    header.stats = sim->stats;
+    header.tracker_id = sim->tracker.id;
+    header.tracker_cut = sim->tracker.cut;
+#endif
+
+    size_t length = strlen(sim->checkpoint.filename);
+    char* temporary = malloc(length + 5);
+    if (!temporary) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    memcpy(temporary, sim->checkpoint.filename, length);
+    strcpy(temporary + length, ".tmp");
+
+    output_flush(&sim->output);
+    fflush(stdout);
+
+    FILE* file = fopen(temporary, "wb");
+    bool written = file != NULL;
+    if (written) {
+        written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(sim->processes, sizeof(Process), (size_t)sim->num_processes, file) == (size_t)sim->num_processes &&
+                  fwrite(sim->phases, sizeof(SimTime), (size_t)sim->num_phase_entries, file) == (size_t)sim->num_phase_entries;
+        if (queue != NULL) {
+            // The ring may wrap around its end
+            for (int i = 0; written && i < queue->size; i++) {
+                written = fwrite(&queue->items[(queue->head + i) % queue->capacity], sizeof(int), 1, file) == 1;
+            }
+        } else if (written) {
+            written = fwrite(heap->items, sizeof(int), (size_t)heap->size, file) == (size_t)heap->size;
+        }
+        written = written &&
+                  fwrite(sim->blocked.items, sizeof(BlockedProcess), (size_t)sim->blocked.size, file) == (size_t)sim->blocked.size &&
+                  fwrite(sim->sketches, sizeof(sim->sketches), 1, file) == 1;
+        written = fclose(file) == 0 && written;
+    }
+    written = written && rename(temporary, sim->checkpoint.filename) == 0;
+    if (!written) {
+        unlink(temporary);
+    }
+    free(temporary);
+    return written;
+}
+
+/**
+ * Restores the simulator from a mapped checkpoint file, leaving the state
+ * of the event loop in resume
+ * @param data Contents of the file
+ * @param size Length of the file
+ * @param resume Receives the loop state; its ready processes point into data
+ * @return Description of the problem, or NULL if the checkpoint was loaded
+ */
+static const char* load_checkpoint(Simulator* sim, const unsigned char* data, size_t size, ResumeState* resume) {
+    CheckpointHeader header;
+    if (size < sizeof(header)) {
+        return "The file is not a checkpoint";
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, CHECKPOINT_MAGIC, 4) != 0 || header.version != CHECKPOINT_VERSION ||
+        header.process_size != sizeof(Process)) {
+        return "The file is not a checkpoint of this simulator";
+    }
+    if (header.num_processes < 0 || header.num_phase_entries < 0 || header.ready_size < 0 ||
+        header.blocked_size < 0 || header.ready_size > header.num_processes) {
+        return "The checkpoint is corrupt";
+    }
+
+    size_t process_bytes = (size_t)header.num_processes * sizeof(Process);
+    size_t phase_bytes = (size_t)header.num_phase_entries * sizeof(SimTime);
+    size_t ready_bytes = (size_t)header.ready_size * sizeof(int);
+    size_t blocked_bytes = (size_t)header.blocked_size * sizeof(BlockedProcess);
+    if (size != sizeof(header) + process_bytes + phase_bytes + ready_bytes + blocked_bytes + sizeof(sim->sketches)) {
+        return "The checkpoint is truncated";
+    }
+    const unsigned char* section = data + sizeof(header);
+
+    free_processes(sim);
+    reserve_processes(sim, header.num_processes);
+    memcpy(sim->processes, section, process_bytes);
+    sim->num_processes = header.num_processes;
+    section += process_bytes;
+
+    sim->phases = malloc(phase_bytes > 0 ? phase_bytes : 1);
+    if (!sim->phases) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    memcpy(sim->phases, section, phase_bytes);
+    sim->num_phase_entries = header.num_phase_entries;
+    sim->phase_capacity = header.num_phase_entries;
+    section += phase_bytes;
+
+    // Left in the mapping until the event loop has taken the ready processes
+    resume->ready = (const int*)section;
+    resume->ready_size = header.ready_size;
+    resume->current_time = header.current_time;
+    resume->preempted = header.preempted;
+    section += ready_bytes;
+
+    sim->blocked.size = 0;
+    for (int i = 0; i < header.blocked_size; i++) {
+        BlockedProcess item;
+        memcpy(&item, section + (size_t)i * sizeof(item), sizeof(item));
+        blocked_push(&sim->blocked, item.wake_time, item.index);
+    }
+    section += blocked_bytes;
+    memcpy(sim->sketches, section, sizeof(sim->sketches));
+
+    sim->next_arrival = header.next_arrival;
+    sim->ready_count = header.ready_count;
+    sim->completed_count = header.completed_count;
+    sim->segments = header.segments;
+    sim->pending_segment = header.pending_segment;
+#ifdef SCHEDULER_STATS
+    sim->stats = header.stats;
+    sim->tracker.id = header.tracker_id;
+    sim->tracker.cut = header.tracker_cut != 0;
+#endif
+    sim->checkpoint.policy = (Policy)header.policy;
+    sim->checkpoint.quantum = header.quantum;
+    return NULL;
+}
+
+/**
+ * Continues a run from a checkpoint written by simulator_set_checkpoint()
+ * and runs it to completion, as run_simulation() would have; checkpoints are
+ * written again if the simulator has a checkpoint file
+ * @param filename Checkpoint file
+ * @param policy Set to the policy of the run
+ * @return Description of the problem, or NULL once the run has completed
+ */
+const char* simulator_resume(Simulator* sim, const char* filename, Policy* policy) {
+    if (sim->engine != ENGINE_EVENT || sim->num_cores > 1) {
+        return "Checkpoints support FCFS, SJF and Round Robin on the event engine with one core";
+    }
+    int fd = open(filename, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return "Could not open the checkpoint";
+    }
+    if (info.st_size == 0) {
+        close(fd);
+        return "The file is not a checkpoint";
+    }
+    const unsigned char* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return "Could not map the checkpoint";
+    }
+
+    ResumeState resume;
+    const char* problem = load_checkpoint(sim, data, (size_t)info.st_size, &resume);
+    if (problem == NULL) {
+        *policy = sim->checkpoint.policy;
+        sim->checkpoint.last_time = monotonic_clock();
+        sim->checkpoint.countdown = CHECKPOINT_POLL_ITERATIONS;
+        sim->what_if.recording = false;
+        sim->polled = sim->checkpoint.filename != NULL;
+        sim->resume = &resume;
+        switch (sim->checkpoint.policy) {
+        case POLICY_FCFS:
+            simulate_fcfs_events(sim);
+            break;
+        case POLICY_SJF:
+            simulate_sjf_events(sim);
+            break;
+        case POLICY_RR:
+            simulate_round_robin_events(sim, sim->checkpoint.quantum);
+            break;
+        default:
+            problem = "The checkpoint is corrupt";
+            break;
+        }
+        sim->resume = NULL;
+    }
+    munmap((void*)data, (size_t)info.st_size);
+    return problem;
+}
+
+/**
+ * Makes the next runs keep snapshots of their event loop in memory, so that
+ * run_what_if() can re-simulate edits of the workload from the last snapshot
+ * before the edit matters. A snapshot copies the ready and blocked
+ * processes, and is taken no sooner than that many iterations after the last
+ * one, so the snapshots take memory and time linear in the length of the run
+ * @param interval Fewest event loop iterations between snapshots, or 0 to stop recording
+ */
+void simulator_set_snapshots(Simulator* sim, int interval) {
+    sim->what_if.interval = interval;
+}
+
+/**
+ * Takes a snapshot when the countdown since the last one has run out
+ * Called at the top of the event loop of a recording run
+ * @param current_time Simulation time at the top of the event loop
+ * @param preempted Round Robin process to requeue first, -1 if none
+ * @param queue Ready queue, or NULL when the run uses a heap
+ * @param heap Ready heap, or NULL when the run uses a queue
+ */
+static void record_snapshot(Simulator* sim, SimTime current_time, int preempted, const RunQueue* queue, const ProcessHeap* heap) {
+    WhatIfLog* log = &sim->what_if;
+    if (--log->countdown > 0) {
+        return;
+    }
+
+    int ready_size = queue != NULL ? queue->size : heap->size;
+    int live = ready_size + sim->blocked.size + (preempted >= 0 ? 1 : 0);
+    if (log->num_snapshots == log->snapshot_capacity) {
+        size_t capacity = (size_t)log->snapshot_capacity;
+        log->snapshots = reserve_items(log->snapshots, &capacity, capacity + 1, sizeof(Snapshot));
+        log->snapshot_capacity = (int)capacity;
+    }
+    log->ready = reserve_items(log->ready, &log->ready_capacity, log->ready_used + ready_size, sizeof(int));
+    log->blocked = reserve_items(log->blocked, &log->blocked_capacity, log->blocked_used + sim->blocked.size, sizeof(BlockedProcess));
+    log->live = reserve_items(log->live, &log->live_capacity, log->live_used + live, sizeof(Process));
+
+    Snapshot* snapshot = &log->snapshots[log->num_snapshots++];
+    snapshot->current_time = current_time;
+    snapshot->preempted = preempted;
+    snapshot->next_arrival = sim->next_arrival;
+    snapshot->ready_count = sim->ready_count;
+    snapshot->completed_count = sim->completed_count;
+    snapshot->segments = sim->segments;
+    snapshot->first_ready = log->ready_used;
+    snapshot->ready_size = ready_size;
+    snapshot->first_blocked = log->blocked_used;
+    snapshot->blocked_size = sim->blocked.size;
+    snapshot->first_live = log->live_used;
+
+    for (int i = 0; i < ready_size; i++) {
+        int index = queue != NULL ? queue->items[(queue->head + i) % queue->capacity] : heap->items[i];
+        log->ready[log->ready_used++] = index;
+        log->live[log->live_used++] = sim->processes[index];
+    }
+    for (int i = 0; i < sim->blocked.size; i++) {
+        log->blocked[log->blocked_used++] = sim->blocked.items[i];
+        log->live[log->live_used++] = sim->processes[sim->blocked.items[i].index];
+    }
+    if (preempted >= 0) {
+        log->live[log->live_used++] = sim->processes[preempted];
+    }
+    log->countdown = live > log->interval ? live : log->interval;
+}
+
+/**
+ * Keeps what run_what_if() needs from a recorded run that just finished:
+ * its totals, and where each process ended up in the sorted table
+ */
+static void finish_recording(Simulator* sim) {
+    WhatIfLog* log = &sim->what_if;
+    log->recording = false;
+    free(log->index_of_id);
+    log->index_of_id = malloc((size_t)(sim->num_processes > 0 ? sim->num_processes : 1) * sizeof(int));
+    if (!log->index_of_id) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+
+    log->total_wait_time = 0;
+    log->total_turnaround_time = 0;
+    log->makespan = 0;
+    for (int i = 0; i < sim->num_processes; i++) {
+        const Process* p = &sim->processes[i];
+        log->index_of_id[p->id] = i;
+        log->total_wait_time += p->wait_time;
+        log->total_turnaround_time += p->turnaround_time;
+        if (p->completion_time > log->makespan) {
+            log->makespan = p->completion_time;
+        }
+    }
+    log->segments = sim->segments;
+    log->recorded = true;
+}
+
+/**
+ * Re-simulates the last run as if one process had a different first CPU
+ * burst, without changing the results it left in the process table
+ * Nothing before the process arrives can change, so the what-if run starts
+ * from the last snapshot taken before then, and stops as soon as it reaches
+ * the state of a later snapshot, from which on the two runs are the same.
+ * Without I/O bursts, FCFS needs no snapshots: each completion time is the
+ * later of the arrival and the completion before it, plus the burst, so only
+ * the completions until an idle gap absorbs the change are recomputed
+ * @param id ID of the process to edit
+ * @param burst_time CPU time of its first CPU burst in the what-if run, positive
+ * @param summary Receives the averages, makespan and segments of the what-if run
+ * @return Number of processes re-simulated, or -1 if the last run was not
+ *         recorded with simulator_set_snapshots() or there is no such process
+ */
+int run_what_if(Simulator* sim, int id, SimTime burst_time, RunSummary* summary) {
+    WhatIfLog* log = &sim->what_if;
+    if (!log->recorded || id < 0 || id >= sim->num_processes || burst_time <= 0) {
+        return -1;
+    }
+    int edited = log->index_of_id[id];
+    if (log->policy == POLICY_FCFS && sim->num_phase_entries == 0) {
+        return what_if_fcfs(sim, edited, burst_time, summary);
+    }
+
+    // The last snapshot at which the edited process had not arrived yet
+    int low = 0;
+    int high = log->num_snapshots - 1;
+    while (low < high) {
+        int middle = low + (high - low + 1) / 2;
+        if (log->snapshots[middle].next_arrival <= edited) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    const Snapshot* snapshot = &log->snapshots[low];
+
+    // Put the live processes back as they were at the snapshot
+    log->journal_size = 0;
+    const Process* live = &log->live[snapshot->first_live];
+    const int* ready = &log->ready[snapshot->first_ready];
+    const BlockedProcess* blocked = &log->blocked[snapshot->first_blocked];
+    for (int i = 0; i < snapshot->ready_size; i++) {
+        journal_process(sim, ready[i]);
+        sim->processes[ready[i]] = *live++;
+    }
+    sim->blocked.size = 0;
+    for (int i = 0; i < snapshot->blocked_size; i++) {
+        journal_process(sim, blocked[i].index);
+        sim->processes[blocked[i].index] = *live++;
+        blocked_push(&sim->blocked, blocked[i].wake_time, blocked[i].index);
+    }
+    if (snapshot->preempted >= 0) {
+        journal_process(sim, snapshot->preempted);
+        sim->processes[snapshot->preempted] = *live;
+    }
+    sim->next_arrival = snapshot->next_arrival;
+    sim->ready_count = snapshot->ready_count;
+    sim->completed_count = snapshot->completed_count;
+    sim->segments = snapshot->segments;
+    memcpy(log->sketches, sim->sketches, sizeof(sim->sketches));
+#ifdef SCHEDULER_STATS
+    SimulatorStats stats = sim->stats;
+    SwitchTracker tracker = sim->tracker;
+#endif
+
+    // The what-if run prints nothing
+    TraceLevel trace_level = sim->trace_level;
+    FILE* binary_trace = sim->binary_trace.file;
+    sim->trace_level = TRACE_SUMMARY;
+    sim->binary_trace.file = NULL;
+
+    ResumeState resume;
+    resume.ready = ready;
+    resume.ready_size = snapshot->ready_size;
+    resume.current_time = snapshot->current_time;
+    resume.preempted = snapshot->preempted;
+    sim->resume = &resume;
+    log->replaying = true;
+    log->edited = edited;
+    log->edited_burst = burst_time;
+    log->prepared = snapshot->next_arrival;
+    log->next_snapshot = low + 1;
+    log->converged = false;
+    sim->polled = true;
+    switch (log->policy) {
+    case POLICY_SJF:
+        simulate_sjf_events(sim);
+        break;
+    case POLICY_RR:
+        simulate_round_robin_events(sim, log->quantum);
+        break;
+    default:
+        simulate_fcfs_events(sim);
+        break;
+    }
+    log->replaying = false;
+    sim->trace_level = trace_level;
+    sim->binary_trace.file = binary_trace;
+
+    // Processes the what-if run did not complete end as in the recorded run,
+    // apart from the wait of the edited process, which ran longer or shorter
+    TimeTotal total_wait_time = log->total_wait_time;
+    TimeTotal total_turnaround_time = log->total_turnaround_time;
+    SimTime makespan = log->converged ? log->makespan : 0;
+    for (int j = 0; j < log->journal_size; j++) {
+        const Process* p = &sim->processes[log->journal[j]];
+        const Process* recorded = &log->saved[j];
+        if (p->completed) {
+            total_wait_time += p->wait_time - recorded->wait_time;
+            total_turnaround_time += p->turnaround_time - recorded->turnaround_time;
+            if (p->completion_time > makespan) {
+                makespan = p->completion_time;
+            }
+        } else if (log->journal[j] == edited) {
+            total_wait_time += recorded->burst_time - p->burst_time;
+        }
+    }
+    summary->average_wait_time = (double)total_wait_time / sim->num_processes;
+    summary->average_turnaround_time = (double)total_turnaround_time / sim->num_processes;
+    summary->makespan = makespan;
+    summary->segments = log->converged ? log->segments - log->snapshots[log->next_snapshot].segments + sim->segments
+                                       : sim->segments;
+
+    // Leave the recorded run in the table
+    for (int j = 0; j < log->journal_size; j++) {
+        sim->processes[log->journal[j]] = log->saved[j];
+    }
+    sim->next_arrival = sim->num_processes;
+    sim->ready_count = 0;
+    sim->completed_count = sim->num_processes;
+    sim->segments = log->segments;
+    sim->blocked.size = 0;
+    memcpy(sim->sketches, log->sketches, sizeof(sim->sketches));
+#ifdef SCHEDULER_STATS
+    sim->stats = stats;
+    sim->tracker = tracker;
+#endif
+    return log->journal_size;
+}
+
+/**
+ * What-if run of FCFS without I/O bursts: processes run in table order, so
+ * completion times follow from the one before, until a completion time
+ * comes out as it was in the recorded run and all later ones do too
+ * @param edited Index of the process to edit
+ * @param burst_time CPU time it is given
+ * @param summary Receives the results of the what-if run
+ * @return Number of processes whose completion was recomputed
+ */
+static int what_if_fcfs(Simulator* sim, int edited, SimTime burst_time, RunSummary* summary) {
+    const WhatIfLog* log = &sim->what_if;
+    TimeTotal total_wait_time = log->total_wait_time + sim->processes[edited].burst_time - burst_time;
+    TimeTotal total_turnaround_time = log->total_turnaround_time;
+    SimTime makespan = log->makespan;
+    SimTime previous = edited > 0 ? sim->processes[edited - 1].completion_time : 0;
+
+    int i = edited;
+    while (i < sim->num_processes) {
+        const Process* p = &sim->processes[i];
+        SimTime start = p->arrival_time > previous ? p->arrival_time : previous;
+        SimTime completion = start + (i == edited ? burst_time : p->burst_time);
+        if (i > edited && completion == p->completion_time) {
+            break;
+        }
+        total_wait_time += completion - p->completion_time;
+        total_turnaround_time += completion - p->completion_time;
+        previous = completion;
+        i++;
+    }
+    if (i == sim->num_processes) {
+        makespan = previous;
+    }
+
+    summary->average_wait_time = (double)total_wait_time / sim->num_processes;
+    summary->average_turnaround_time = (double)total_turnaround_time / sim->num_processes;
+    summary->makespan = makespan;
+    summary->segments = log->segments;
+    return i - edited;
+}
+
+/**
+ * Steps a what-if run at the top of its event loop: stops it once its state
+ * matches the recorded run's, and otherwise readies the processes about to
+ * arrive, which the table holds as they ended the recorded run
+ * @param current_time Simulation time at the top of the event loop
+ * @param preempted Round Robin process to requeue first, -1 if none
+ * @param queue Ready queue, or NULL when the run uses a heap
+ * @param heap Ready heap, or NULL when the run uses a queue
+ * @return true if the rest of the run would repeat the recorded run
+ */
+static bool what_if_poll(Simulator* sim, SimTime current_time, int preempted, const RunQueue* queue, const ProcessHeap* heap) {
+    WhatIfLog* log = &sim->what_if;
+    while (log->next_snapshot < log->num_snapshots && log->snapshots[log->next_snapshot].current_time < current_time) {
+        log->next_snapshot++;
+    }
+    // Loop iterations start at increasing times, so at most one snapshot can match
+    if (log->next_snapshot < log->num_snapshots) {
+        const Snapshot* snapshot = &log->snapshots[log->next_snapshot];
+        if (snapshot->current_time == current_time && snapshot->next_arrival > log->edited &&
+            snapshot_matches(sim, snapshot, preempted, queue, heap)) {
+            log->converged = true;
+            return true;
+        }
+    }
+
+    while (log->prepared < sim->num_processes && sim->processes[log->prepared].arrival_time <= current_time) {
+        Process* p = &sim->processes[log->prepared];
+        journal_process(sim, log->prepared);
+        reset_process(sim, p);
+        if (log->prepared == log->edited) {
+            p->burst_time += log->edited_burst - p->remaining_time;
+            p->remaining_time = log->edited_burst;
+        }
+        log->prepared++;
+    }
+    return false;
+}
+
+/**
+ * Compares the state of a what-if run with a snapshot of the recorded run
+ * The processes that had arrived and are not live have completed in both,
+ * and the ones that had not arrived are the same in both
+ * @param snapshot Snapshot taken at the same simulation time
+ * @param preempted Round Robin process to requeue first, -1 if none
+ * @param queue Ready queue, or NULL when the run uses a heap
+ * @param heap Ready heap, or NULL when the run uses a queue
+ * @return true if the runs have the same ready, blocked and preempted processes, in the same state
+ */
+static bool snapshot_matches(const Simulator* sim, const Snapshot* snapshot, int preempted, const RunQueue* queue, const ProcessHeap* heap) {
+    const WhatIfLog* log = &sim->what_if;
+    int ready_size = queue != NULL ? queue->size : heap->size;
+    if (snapshot->next_arrival != sim->next_arrival || snapshot->completed_count != sim->completed_count ||
+        snapshot->ready_count != sim->ready_count || snapshot->preempted != preempted ||
+        snapshot->ready_size != ready_size || snapshot->blocked_size != sim->blocked.size) {
+        return false;
+    }
+
+    const Process* live = &log->live[snapshot->first_live];
+    for (int i = 0; i < ready_size; i++) {
+        int index = queue != NULL ? queue->items[(queue->head + i) % queue->capacity] : heap->items[i];
+        if (index != log->ready[snapshot->first_ready + i] || !same_progress(&sim->processes[index], live++)) {
+            return false;
+        }
+    }
+    for (int i = 0; i < sim->blocked.size; i++) {
+        const BlockedProcess* item = &log->blocked[snapshot->first_blocked + i];
+        if (item->index != sim->blocked.items[i].index || item->wake_time != sim->blocked.items[i].wake_time ||
+            !same_progress(&sim->processes[item->index], live++)) {
+            return false;
+        }
+    }
+    return preempted < 0 || same_progress(&sim->processes[preempted], live);
+}
+
+/**
+ * Checks whether a process has made the same progress in two runs
+ * @param a Process in one run
+ * @param b The same process in the other run
+ * @return true if both runs will treat it the same from here on
+ */
+static bool same_progress(const Process* a, const Process* b) {
+    return a->remaining_time == b->remaining_time && a->phase == b->phase &&
+           a->blocked_time == b->blocked_time && a->start_time == b->start_time;
+}
+
+/**
+ * Saves the recorded state of a process the what-if run is about to change
+ * @param index Index of the process
+ */
+static void journal_process(Simulator* sim, int index) {
+    WhatIfLog* log = &sim->what_if;
+    if (log->journal_size == log->journal_capacity) {
+        int capacity = log->journal_capacity > 0 ? log->journal_capacity * 2 : 64;
+        int* journal = realloc(log->journal, (size_t)capacity * sizeof(int));
+        Process* saved = realloc(log->saved, (size_t)capacity * sizeof(Process));
+        if (!journal || !saved) {
+            printf("Error: Out of memory\n");
+            exit(1);
+        }
+        log->journal = journal;
+        log->saved = saved;
+        log->journal_capacity = capacity;
+    }
+    log->journal[log->journal_size] = index;
+    log->saved[log->journal_size] = sim->processes[index];
+    log->journal_size++;
+}
+
+/**
+ * Hook at the top of the event loops of FCFS, SJF and Round Robin, for
+ * checkpoints, snapshots and what-if runs
+ * @param current_time Simulation time at the top of the event loop
+ * @param preempted Round Robin process to requeue first, -1 if none
+ * @param queue Ready queue, or NULL when the run uses a heap
+ * @param heap Ready heap, or NULL when the run uses a queue
+ * @return true if the loop should stop
+ */
+static bool event_loop_poll(Simulator* sim, SimTime current_time, int preempted, const RunQueue* queue, const ProcessHeap* heap) {
+    if (sim->what_if.replaying) {
+        return what_if_poll(sim, current_time, preempted, queue, heap);
+    }
+    if (sim->checkpoint.filename != NULL) {
+        checkpoint_poll(sim, current_time, preempted, queue, heap);
+    }
+    if (sim->what_if.recording) {
+        record_snapshot(sim, current_time, preempted, queue, heap);
+    }
+    return false;
+}
+
+/**
+ * Grows an array to hold at least a number of items, doubling its capacity
+ * @param items Array to grow, may be NULL
+ * @param capacity Items the array can hold; updated when it grows
+ * @param needed Items it must hold
+ * @param size Size of one item
+ * @return The array, possibly moved
+ */
+static void* reserve_items(void* items, size_t* capacity, size_t needed, size_t size) {
+    if (needed <= *capacity) {
+        return items;
+    }
+    size_t grown = *capacity > 0 ? *capacity * 2 : 64;
+    if (grown < needed) {
+        grown = needed;
+    }
+    items = realloc(items, grown * size);
+    if (!items) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    *capacity = grown;
+    return items;
+}
+
+/**
+ * Writes an output buffer to stdout
+ * @param out Buffer to empty
+ */
+static void output_flush(OutputBuffer* out) {
+    if (out->length > 0) {
+        fwrite(out->data, 1, out->length, stdout);
+        out->length = 0;
+    }
+}
+
+/**
+ * Appends text to an output buffer
+ * @param out Buffer to append to
+ * @param text Null-terminated text to append
+ */
+static void output_text(OutputBuffer* out, const char* text) {
+    size_t length = strlen(text);
+    if (out->length + length > OUTPUT_BUFFER_SIZE) {
+        output_flush(out);
+    }
+    memcpy(out->data + out->length, text, length);
+    out->length += length;
+}
+
+/**
+ * Appends a decimal integer to an output buffer, like printf("%*d")
+ * @param out Buffer to append to
+ * @param value Integer to format
+ * @param width Minimum field width, padded with spaces on the left
+ */
+static void output_int(OutputBuffer* out, int64_t value, int width) {
+    char digits[24];
+    int count = 0;
+    // Work on the magnitude as unsigned so INT64_MIN does not overflow
+    uint64_t magnitude = value < 0 ? 0u - (uint64_t)value : (uint64_t)value;
+
+    do {
+        digits[count++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        digits[count++] = '-';
+    }
+
+    if (out->length + count + width > OUTPUT_BUFFER_SIZE) {
+        output_flush(out);
+    }
+    for (int pad = count; pad < width; pad++) {
+        out->data[out->length++] = ' ';
+    }
+    while (count > 0) {
+        out->data[out->length++] = digits[--count];
+    }
+}
+
+/**
+ * Finds the process with shortest remaining time that has arrived
+ * @param current_time Current simulation time
+ * @return Pointer to process with shortest remaining time, or NULL if none available
+ */
+static Process* get_next_sjf_process(Simulator* sim, SimTime current_time) {
+    Process* shortest = NULL;       // Pointer to the shortest process
+    SimTime shortest_time = SIM_TIME_MAX; // Shortest remaining time found so far
+
+    // Iterate over all processes
+    for (int i = 0; i < sim->num_processes; i++) {
+        // Check if process is not completed and has arrived
+        if (!sim->processes[i].completed && 
+            sim->processes[i].arrival_time <= current_time) {
+            // Find the process with the shortest remaining time, earliest arrival first on ties
+            if (sim->processes[i].remaining_time < shortest_time ||
+                (shortest != NULL && sim->processes[i].remaining_time == shortest_time &&
+                 sim->processes[i].arrival_time < shortest->arrival_time)) {
+                shortest_time = sim->processes[i].remaining_time;
+                shortest = &sim->processes[i];
+            }
+        }
+    }
+    STATS_ADD(sim, scan_iterations, sim->num_processes);
+
+    return shortest;  // Return the process with shortest remaining time
+}
 
-// Function prototypes
-void read_input_file(const char* filename);
-void simulate_fcfs();
-void simulate_sjf();
-void simulate_round_robin(int quantum);
-void print_process_stats();
-void print_final_stats();
-bool all_processes_complete();
-Process* get_next_sjf_process(int current_time);
-void update_wait_times(int current_time, int active_process_id);
-void update_turnaround_times(int current_time);
+/**
+ * Orders processes for Shortest Job First selection
+ * Shortest remaining time first, then earliest arrival, then lowest ID,
+ * which is the same order get_next_sjf_process() picks in
+ * @param a First process
+ * @param b Second process
+ * @return true if a should run before b
+ */
+static bool sjf_before(const Process* a, const Process* b) {
+    if (a->remaining_time != b->remaining_time) {
+        return a->remaining_time < b->remaining_time;
+    }
+    if (a->arrival_time != b->arrival_time) {
+        return a->arrival_time < b->arrival_time;
+    }
+    return a->id < b->id;
+}
 
 /**
- * Reads process information from input file and initializes process array
- * File format: P0,3 (Process 0 with burst time 3)
- * @param filename Name of the input CSV file
+ * Allocates an empty heap
+ * @param heap Heap to initialize
+ * @param capacity Maximum number of processes the heap will hold
+ * @param processes Process table the queued indices refer to
  */
-void read_input_file(const char* filename) {
-    // Open the file for reading
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        printf("Error: Could not open file %s\n", filename);
+static void heap_init(ProcessHeap* heap, int capacity, const Process* processes) {
+    heap->items = capacity > 0 ? malloc(capacity * sizeof(int)) : NULL;
+    heap->capacity = capacity;
+    heap->size = 0;
+    heap->processes = processes;
+    if (capacity > 0 && !heap->items) {
+        printf("Error: Out of memory\n");
         exit(1);
     }
+}
 
-    char line[MAX_LINE_LENGTH];
-    // Read each line from the file
-    while (fgets(line, sizeof(line), file)) {
-        char process_id[10];
-        int burst_time;
-        
-        // Parse the line to extract process ID and burst time
-        if (sscanf(line, "P%[^,],%d", process_id, &burst_time) == 2) {
-            // Initialize the process structure
-            processes[num_processes].id = num_processes;
-            processes[num_processes].burst_time = burst_time;
-            processes[num_processes].remaining_time = burst_time;
-            processes[num_processes].arrival_time = num_processes;  // For simplicity, arrival time is process ID
-            processes[num_processes].wait_time = 0;
-            processes[num_processes].turnaround_time = 0;
-            processes[num_processes].completed = false;
-            num_processes++;
+/**
+ * Releases the storage of a heap
+ * @param heap Heap to free
+ */
+static void heap_free(ProcessHeap* heap) {
+    free(heap->items);
+    heap->items = NULL;
+    heap->capacity = 0;
+    heap->size = 0;
+}
+
+/**
+ * Inserts a process into the heap
+ * @param heap Heap to insert into
+ * @param index Index of the process in the process table
+ */
+static void heap_push(ProcessHeap* heap, int index) {
+    int i = heap->size++;
+
+    // Sift up until the parent runs first
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!sjf_before(&heap->processes[index], &heap->processes[heap->items[parent]])) {
+            break;
         }
+        heap->items[i] = heap->items[parent];
+        i = parent;
     }
-    fclose(file);
+    heap->items[i] = index;
 }
 
 /**
- * Simulates First Come First Served scheduling algorithm
- * Non-preemptive: each process runs to completion
+ * Removes the process on top of the heap
+ * @param heap Heap to remove from (must not be empty)
+ * @return Index of the removed process
  */
-void simulate_fcfs() {
-    printf("First Come First Served\n");
-    int current_time = 0;    // Simulation time
-    int current_process = 0; // Index of the current process being executed
+static int heap_pop(ProcessHeap* heap) {
+    int top = heap->items[0];
+    int last = heap->items[--heap->size];
+    int i = 0;
 
-    // Loop until all processes are complete
-    while (!all_processes_complete()) {
-        // Find next uncompleted process
-        while (current_process < num_processes && processes[current_process].completed) {
-            current_process++;
+    // Sift the last item down from the root
+    while (2 * i + 1 < heap->size) {
+        int child = 2 * i + 1;
+        if (child + 1 < heap->size &&
+            sjf_before(&heap->processes[heap->items[child + 1]], &heap->processes[heap->items[child]])) {
+            child++;
+        }
+        if (!sjf_before(&heap->processes[heap->items[child]], &heap->processes[last])) {
+            break;
+        }
+        heap->items[i] = heap->items[child];
+        i = child;
+    }
+    if (heap->size > 0) {
+        heap->items[i] = last;
+    }
+    return top;
+}
+/**
+ * Doubles the capacity of a heap
+ * @param heap Heap to grow
+ */
+static void heap_grow(ProcessHeap* heap) {
+    int capacity = heap->capacity > 0 ? heap->capacity * 2 : 16;
+    int* items = realloc(heap->items, (size_t)capacity * sizeof(int));
+    if (!items) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    heap->items = items;
+    heap->capacity = capacity;
+}
+
+/**
+ * Orders processes in the blocked queue
+ * @param a First blocked process
+ * @param b Second blocked process
+ * @return true if a wakes before b, or at the same time and arrived first
+ */
+static bool blocked_before(const BlockedProcess* a, const BlockedProcess* b) {
+    if (a->wake_time != b->wake_time) {
+        return a->wake_time < b->wake_time;
+    }
+    return a->index < b->index;
+}
+
+/**
+ * Adds a process to the blocked queue, growing it when full
+ * @param queue Blocked queue
+ * @param wake_time Time the process's I/O burst completes
+ * @param index Index of the process in the process table
+ */
+static void blocked_push(BlockedQueue* queue, SimTime wake_time, int index) {
+    if (queue->size == queue->capacity) {
+        int capacity = queue->capacity > 0 ? queue->capacity * 2 : 16;
+        BlockedProcess* items = realloc(queue->items, (size_t)capacity * sizeof(BlockedProcess));
+        if (!items) {
+            printf("Error: Out of memory\n");
+            exit(1);
         }
+        queue->items = items;
+        queue->capacity = capacity;
+    }
 
-        if (current_process < num_processes) {
-            // Process current process
-            printf("T%d : P%d - Burst left %2d, Wait time %d, Turnaround time %d\n",
-                current_time,
-                processes[current_process].id,
-                processes[current_process].remaining_time,
-                processes[current_process].wait_time,
-                processes[current_process].turnaround_time);
+    BlockedProcess item = { wake_time, index };
+    int i = queue->size++;
 
-            // Decrease remaining time of current process
-            processes[current_process].remaining_time--;
-                
-            // If process has finished execution
-            if (processes[current_process].remaining_time == 0) {
-                processes[current_process].completed = true;
-            }
+    // Sift up until the parent wakes first
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!blocked_before(&item, &queue->items[parent])) {
+            break;
         }
+        queue->items[i] = queue->items[parent];
+        i = parent;
+    }
+    queue->items[i] = item;
+}
 
-        // Update wait times and turnaround times
-        update_wait_times(current_time, current_process);
-        update_turnaround_times(current_time);
-        // Increment current time
-        current_time++;
+/**
+ * Removes the process that wakes first from the blocked queue
+ * @param queue Non-empty blocked queue
+ * @return Index of the removed process
+ */
+static int blocked_pop(BlockedQueue* queue) {
+    int top = queue->items[0].index;
+    BlockedProcess last = queue->items[--queue->size];
+    int i = 0;
+
+    // Sift the last item down from the root
+    while (2 * i + 1 < queue->size) {
+        int child = 2 * i + 1;
+        if (child + 1 < queue->size && blocked_before(&queue->items[child + 1], &queue->items[child])) {
+            child++;
+        }
+        if (!blocked_before(&queue->items[child], &last)) {
+            break;
+        }
+        queue->items[i] = queue->items[child];
+        i = child;
+    }
+    if (queue->size > 0) {
+        queue->items[i] = last;
     }
+    return top;
 }
 
+
 /**
- * Simulates Shortest Job First scheduling algorithm
- * Preemptive: shorter processes can interrupt longer ones
+ * Allocates an empty run queue
+ * Every process is queued at most once, so the process count is always enough
+ * @param queue Queue to initialize
+ * @param capacity Maximum number of processes the queue will hold
  */
-void simulate_sjf() {
-    printf("Shortest Job First\n");
-    int current_time = 0;      // Simulation time
-    Process* current_process = NULL; // Pointer to the current process being executed
+static void queue_init(RunQueue* queue, int capacity) {
+    queue->items = capacity > 0 ? malloc(capacity * sizeof(int)) : NULL;
+    queue->capacity = capacity;
+    queue->head = 0;
+    queue->size = 0;
+    if (capacity > 0 && !queue->items) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+}
 
-    // Loop until all processes are complete
-    while (!all_processes_complete()) {
-        // Get the next process with the shortest remaining time
-        current_process = get_next_sjf_process(current_time);
-        
-        if (current_process != NULL) {
-            // Process the current process
-            printf("T%d : P%d - Burst left %2d, Wait time %d, Turnaround time %d\n",
-                current_time,
-                current_process->id,
-                current_process->remaining_time,
-                current_process->wait_time,
-                current_process->turnaround_time);
+/**
+ * Releases the storage of a run queue
+ * @param queue Queue to free
+ */
+static void queue_free(RunQueue* queue) {
+    free(queue->items);
+    queue->items = NULL;
+    queue->capacity = 0;
+    queue->size = 0;
+}
 
-            // Decrease remaining time
-            current_process->remaining_time--;
-                
-            // If process has finished execution
-            if (current_process->remaining_time == 0) {
-                current_process->completed = true;
-            }
+/**
+ * Appends a process at the tail of the queue
+ * @param queue Queue to append to (must not be full)
+ * @param index Index of the process in the process table
+ */
+static void queue_push(RunQueue* queue, int index) {
+    int tail = queue->head + queue->size;
+    if (tail >= queue->capacity) {
+        tail -= queue->capacity;
+    }
+    queue->items[tail] = index;
+    queue->size++;
+}
+
+/**
+ * Removes the process at the head of the queue
+ * @param queue Queue to remove from (must not be empty)
+ * @return Index of the removed process
+ */
+static int queue_pop(RunQueue* queue) {
+    int index = queue->items[queue->head];
+    queue->head++;
+    if (queue->head == queue->capacity) {
+        queue->head = 0;
+    }
+    queue->size--;
+    return index;
+}
+/**
+ * Doubles the capacity of a run queue, keeping its order
+ * @param queue Queue to grow
+ */
+static void queue_grow(RunQueue* queue) {
+    int capacity = queue->capacity > 0 ? queue->capacity * 2 : 16;
+    int* items = malloc((size_t)capacity * sizeof(int));
+    if (!items) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    // Unwrap the ring so the head starts at slot 0
+    for (int i = 0; i < queue->size; i++) {
+        int slot = queue->head + i;
+        items[i] = queue->items[slot >= queue->capacity ? slot - queue->capacity : slot];
+    }
+    free(queue->items);
+    queue->items = items;
+    queue->capacity = capacity;
+    queue->head = 0;
+}
+
+
+/**
+ * Updates wait times for all processes in ready queue
+ * @param current_time Current simulation time
+ * @param active_process_id ID of currently running process (-1 if none)
+ */
+static void update_wait_times(Simulator* sim, SimTime current_time, int active_process_id) {
+    for (int i = 0; i < sim->num_processes; i++) {
+        // If the process is in the ready queue (arrived but not completed and not the active process)
+        if (!sim->processes[i].completed && 
+            sim->processes[i].arrival_time <= current_time && 
+            i != active_process_id) {
+            sim->processes[i].wait_time++;  // Increment wait time
         }
+    }
+}
 
-        // Update wait times and turnaround times
-        update_wait_times(current_time, current_process ? current_process->id : -1);
-        update_turnaround_times(current_time);
-        // Increment current time
-        current_time++;
+/**
+ * Updates turnaround times for all active processes
+ * @param current_time Current simulation time
+ */
+static void update_turnaround_times(Simulator* sim, SimTime current_time) {
+    for (int i = 0; i < sim->num_processes; i++) {
+        // If the process has arrived and not yet completed
+        if (!sim->processes[i].completed && 
+            sim->processes[i].arrival_time <= current_time) {
+            sim->processes[i].turnaround_time++;  // Increment turnaround time
+        }
     }
 }
 
 /**
- * Simulates Round Robin scheduling algorithm
- * Preemptive: processes get fixed time quantum then switch
- * @param quantum Time slice given to each process
+ * Copies the fields touched by the sweeps into contiguous columns
  */
-void simulate_round_robin(int quantum) {
-    printf("Round Robin with Quantum %d\n", quantum);
-    int current_time = 0;        // Simulation time
-    int current_process = 0;     // Index of the current process being executed
-    int time_in_quantum = 0;     // Time spent on the current process in the current quantum
+static void load_columns(Simulator* sim) {
+    size_t words = ((size_t)sim->num_processes + 63) / 64;
+    sim->columns.remaining_time = malloc((size_t)sim->num_processes * sizeof(SimTime));
+    sim->columns.arrival_time = malloc((size_t)sim->num_processes * sizeof(SimTime));
+    sim->columns.wait_time = malloc((size_t)sim->num_processes * sizeof(SimTime));
+    sim->columns.turnaround_time = malloc((size_t)sim->num_processes * sizeof(SimTime));
+    sim->columns.completed = calloc(words > 0 ? words : 1, sizeof(uint64_t));
+    if (sim->num_processes > 0 && (!sim->columns.remaining_time || !sim->columns.arrival_time ||
+        !sim->columns.wait_time || !sim->columns.turnaround_time || !sim->columns.completed)) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
 
-    // Loop until all processes are complete
-    while (!all_processes_complete()) {
-        // Find next uncompleted process that has arrived
-        while (current_process < num_processes && 
-               (processes[current_process].completed || 
-                processes[current_process].arrival_time > current_time)) {
-            // Move to the next process
-            current_process = (current_process + 1) % num_processes;
-            time_in_quantum = 0;  // Reset quantum time when switching processes
-        }
-
-        // If the process is ready to execute
-        if (!processes[current_process].completed && 
-            processes[current_process].arrival_time <= current_time) {
-            
-            // Process the current process
-            printf("T%d : P%d - Burst left %2d, Wait time %d, Turnaround time %d\n",
-                current_time,
-                processes[current_process].id,
-                processes[current_process].remaining_time,
-                processes[current_process].wait_time,
-                processes[current_process].turnaround_time);
-
-            // Decrease remaining time and quantum time
-            processes[current_process].remaining_time--;
-            time_in_quantum++;
-
-            // If process has finished execution
-            if (processes[current_process].remaining_time == 0) {
-                processes[current_process].completed = true;
-                time_in_quantum = 0;
-                // Move to the next process
-                current_process = (current_process + 1) % num_processes;
+    for (int i = 0; i < sim->num_processes; i++) {
+        sim->columns.remaining_time[i] = sim->processes[i].remaining_time;
+        sim->columns.arrival_time[i] = sim->processes[i].arrival_time;
+        sim->columns.wait_time[i] = sim->processes[i].wait_time;
+        sim->columns.turnaround_time[i] = sim->processes[i].turnaround_time;
+        if (sim->processes[i].completed) {
+            sim->columns.completed[i / 64] |= UINT64_C(1) << (i % 64);
+        }
+    }
+}
+
+/**
+ * Releases the sweep columns
+ */
+static void free_columns(Simulator* sim) {
+    free(sim->columns.remaining_time);
+    free(sim->columns.arrival_time);
+    free(sim->columns.wait_time);
+    free(sim->columns.turnaround_time);
+    free(sim->columns.completed);
+    memset(&sim->columns, 0, sizeof(sim->columns));
+}
+
+/**
+ * Column version of get_next_sjf_process()
+ * Whole words of completed processes are skipped without touching the other columns
+ * @param current_time Current simulation time
+ * @return Pointer to process with shortest remaining time, or NULL if none available
+ */
+static Process* get_next_sjf_process_columns(Simulator* sim, SimTime current_time) {
+    int shortest = -1;              // Index of the shortest process
+    SimTime shortest_time = SIM_TIME_MAX; // Shortest remaining time found so far
+
+    for (int base = 0; base < sim->num_processes; base += 64) {
+        uint64_t pending = ~sim->columns.completed[base / 64];
+        while (pending) {
+            int i = base + __builtin_ctzll(pending);
+            pending &= pending - 1;
+            STATS_ADD(sim, scan_iterations, 1);
+            if (i >= sim->num_processes || sim->columns.arrival_time[i] > current_time) {
+                continue;
             }
-            // If time quantum has been reached
-            else if (time_in_quantum == quantum) {
-                time_in_quantum = 0;
-                // Move to the next process
-                current_process = (current_process + 1) % num_processes;
+            if (sim->columns.remaining_time[i] < shortest_time ||
+                (shortest >= 0 && sim->columns.remaining_time[i] == shortest_time &&
+                 sim->columns.arrival_time[i] < sim->columns.arrival_time[shortest])) {
+                shortest_time = sim->columns.remaining_time[i];
+                shortest = i;
             }
         }
+    }
 
-        // Update wait times and turnaround times
-        update_wait_times(current_time, current_process);
-        update_turnaround_times(current_time);
-        // Increment current time
-        current_time++;
+    return shortest >= 0 ? &sim->processes[shortest] : NULL;
+}
+
+/**
+ * Column version of update_wait_times()
+ * @param current_time Current simulation time
+ * @param active_process_id ID of currently running process (-1 if none)
+ */
+static void update_wait_times_columns(Simulator* sim, SimTime current_time, int active_process_id) {
+    for (int base = 0; base < sim->num_processes; base += 64) {
+        uint64_t pending = ~sim->columns.completed[base / 64];
+        while (pending) {
+            int i = base + __builtin_ctzll(pending);
+            pending &= pending - 1;
+            if (i < sim->num_processes && sim->columns.arrival_time[i] <= current_time && i != active_process_id) {
+                sim->columns.wait_time[i]++;
+            }
+        }
     }
 }
 
 /**
- * Finds the process with shortest remaining time that has arrived
+ * Column version of update_turnaround_times()
+ * @param current_time Current simulation time
+ */
+static void update_turnaround_times_columns(Simulator* sim, SimTime current_time) {
+    for (int base = 0; base < sim->num_processes; base += 64) {
+        uint64_t pending = ~sim->columns.completed[base / 64];
+        while (pending) {
+            int i = base + __builtin_ctzll(pending);
+            pending &= pending - 1;
+            if (i < sim->num_processes && sim->columns.arrival_time[i] <= current_time) {
+                sim->columns.turnaround_time[i]++;
+            }
+        }
+    }
+}
+
+/**
+ * Picks the sweep kernels for this CPU
+ * @param allow_simd Whether vector kernels may be used when the CPU supports them
+ */
+static void select_sweep_kernels(Simulator* sim, bool allow_simd) {
+    static const SweepKernels scalar_kernels = {
+        "scalar", get_next_sjf_process_columns, update_wait_times_columns, update_turnaround_times_columns
+    };
+#ifdef HAVE_AVX2_KERNELS
+    static const SweepKernels avx2_kernels = {
+        "avx2", get_next_sjf_process_avx2, update_wait_times_avx2, update_turnaround_times_avx2
+    };
+    if (allow_simd && __builtin_cpu_supports("avx2")) {
+        sim->kernels = &avx2_kernels;
+        return;
+    }
+#endif
+    (void)allow_simd;
+    sim->kernels = &scalar_kernels;
+}
+
+#ifdef HAVE_AVX2_KERNELS
+/**
+ * Expands 8 bits of the completion bitset into a lane mask of pending processes
+ * @param pending_bits Bits set for processes that have not completed
+ * @return All-ones in each 32-bit lane whose bit is set
+ */
+__attribute__((target("avx2")))
+static inline __m256i pending_lanes_avx2(uint32_t pending_bits) {
+    const __m256i select = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    __m256i bits = _mm256_and_si256(_mm256_set1_epi32((int)pending_bits), select);
+    return _mm256_cmpeq_epi32(bits, select);
+}
+
+/**
+ * AVX2 version of get_next_sjf_process_columns()
+ * A min-reduction over the remaining time of ready processes, followed by a
+ * pass over the lanes that tie it to break ties on arrival time and index
  * @param current_time Current simulation time
  * @return Pointer to process with shortest remaining time, or NULL if none available
  */
-Process* get_next_sjf_process(int current_time) {
-    Process* shortest = NULL;       // Pointer to the shortest process
-    int shortest_time = INT_MAX;    // Shortest remaining time found so far
+__attribute__((target("avx2")))
+static Process* get_next_sjf_process_avx2(Simulator* sim, SimTime current_time) {
+    const __m256i now = _mm256_set1_epi32(current_time);
+    int vector_end = sim->num_processes & ~7;    // Processes past this are handled one at a time
+    __m256i best = _mm256_set1_epi32(INT_MAX);
+    int shortest_time = INT_MAX;
 
-    // Iterate over all processes
-    for (int i = 0; i < num_processes; i++) {
-        // Check if process is not completed and has arrived
-        if (!processes[i].completed && 
-            processes[i].arrival_time <= current_time) {
-            // Find the process with the shortest remaining time
-            if (processes[i].remaining_time < shortest_time) {
-                shortest_time = processes[i].remaining_time;
-                shortest = &processes[i];
+    for (int i = 0; i < vector_end; i += 8) {
+        uint32_t pending_bits = (uint32_t)(~sim->columns.completed[i / 64] >> (i % 64)) & 0xff;
+        if (pending_bits == 0) {
+            continue;
+        }
+        __m256i arrival = _mm256_loadu_si256((const __m256i*)&sim->columns.arrival_time[i]);
+        __m256i ready = _mm256_andnot_si256(_mm256_cmpgt_epi32(arrival, now), pending_lanes_avx2(pending_bits));
+        __m256i remaining = _mm256_loadu_si256((const __m256i*)&sim->columns.remaining_time[i]);
+        best = _mm256_min_epi32(best, _mm256_blendv_epi8(best, remaining, ready));
+    }
+
+    // Reduce the eight lane minimums
+    int lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, best);
+    for (int k = 0; k < 8; k++) {
+        if (lanes[k] < shortest_time) {
+            shortest_time = lanes[k];
+        }
+    }
+    for (int i = vector_end; i < sim->num_processes; i++) {
+        if (!(sim->columns.completed[i / 64] >> (i % 64) & 1) && sim->columns.arrival_time[i] <= current_time &&
+            sim->columns.remaining_time[i] < shortest_time) {
+            shortest_time = sim->columns.remaining_time[i];
+        }
+    }
+    if (shortest_time == INT_MAX) {
+        return NULL;
+    }
+
+    // Among the processes with the shortest time, pick the earliest arrival
+    const __m256i target = _mm256_set1_epi32(shortest_time);
+    int shortest = -1;
+    for (int i = 0; i < vector_end; i += 8) {
+        uint32_t pending_bits = (uint32_t)(~sim->columns.completed[i / 64] >> (i % 64)) & 0xff;
+        if (pending_bits == 0) {
+            continue;
+        }
+        __m256i arrival = _mm256_loadu_si256((const __m256i*)&sim->columns.arrival_time[i]);
+        __m256i remaining = _mm256_loadu_si256((const __m256i*)&sim->columns.remaining_time[i]);
+        __m256i ready = _mm256_andnot_si256(_mm256_cmpgt_epi32(arrival, now), pending_lanes_avx2(pending_bits));
+        uint32_t ties = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(
+            _mm256_and_si256(ready, _mm256_cmpeq_epi32(remaining, target))));
+        while (ties) {
+            int j = i + __builtin_ctz(ties);
+            ties &= ties - 1;
+            if (shortest < 0 || sim->columns.arrival_time[j] < sim->columns.arrival_time[shortest]) {
+                shortest = j;
             }
         }
     }
+    for (int i = vector_end; i < sim->num_processes; i++) {
+        if (!(sim->columns.completed[i / 64] >> (i % 64) & 1) && sim->columns.arrival_time[i] <= current_time &&
+            sim->columns.remaining_time[i] == shortest_time &&
+            (shortest < 0 || sim->columns.arrival_time[i] < sim->columns.arrival_time[shortest])) {
+            shortest = i;
+        }
+    }
 
-    return shortest;  // Return the process with shortest remaining time
+    STATS_ADD(sim, scan_iterations, sim->num_processes);
+    return &sim->processes[shortest];
 }
 
 /**
- * Updates wait times for all processes in ready queue
+ * Adds one to a column for every pending process that has arrived
+ * @param column Wait or turnaround column to update
  * @param current_time Current simulation time
- * @param active_process_id ID of currently running process (-1 if none)
  */
-void update_wait_times(int current_time, int active_process_id) {
-    for (int i = 0; i < num_processes; i++) {
-        // If the process is in the ready queue (arrived but not completed and not the active process)
-        if (!processes[i].completed && 
-            processes[i].arrival_time <= current_time && 
-            i != active_process_id) {
-            processes[i].wait_time++;  // Increment wait time
+__attribute__((target("avx2")))
+static void increment_arrived_avx2(Simulator* sim, int* column, SimTime current_time) {
+    const __m256i now = _mm256_set1_epi32(current_time);
+    int vector_end = sim->num_processes & ~7;    // Processes past this are handled one at a time
+
+    for (int i = 0; i < vector_end; i += 8) {
+        uint32_t pending_bits = (uint32_t)(~sim->columns.completed[i / 64] >> (i % 64)) & 0xff;
+        if (pending_bits == 0) {
+            continue;
+        }
+        __m256i arrival = _mm256_loadu_si256((const __m256i*)&sim->columns.arrival_time[i]);
+        // Lanes to increment are all-ones, i.e. -1, so subtracting adds one
+        __m256i increment = _mm256_andnot_si256(_mm256_cmpgt_epi32(arrival, now), pending_lanes_avx2(pending_bits));
+        __m256i value = _mm256_loadu_si256((const __m256i*)&column[i]);
+        _mm256_storeu_si256((__m256i*)&column[i], _mm256_sub_epi32(value, increment));
+    }
+    for (int i = vector_end; i < sim->num_processes; i++) {
+        if (!(sim->columns.completed[i / 64] >> (i % 64) & 1) && sim->columns.arrival_time[i] <= current_time) {
+            column[i]++;
         }
     }
 }
 
 /**
- * Updates turnaround times for all active processes
+ * AVX2 version of update_wait_times_columns()
+ * Increments every ready process, then takes the increment back from the active one
  * @param current_time Current simulation time
+ * @param active_process_id ID of currently running process (-1 if none)
  */
-void update_turnaround_times(int current_time) {
-    for (int i = 0; i < num_processes; i++) {
-        // If the process has arrived and not yet completed
-        if (!processes[i].completed && 
-            processes[i].arrival_time <= current_time) {
-            processes[i].turnaround_time++;  // Increment turnaround time
-        }
+__attribute__((target("avx2")))
+static void update_wait_times_avx2(Simulator* sim, SimTime current_time, int active_process_id) {
+    increment_arrived_avx2(sim, sim->columns.wait_time, current_time);
+
+    int i = active_process_id;
+    if (i >= 0 && i < sim->num_processes && !(sim->columns.completed[i / 64] >> (i % 64) & 1) &&
+        sim->columns.arrival_time[i] <= current_time) {
+        sim->columns.wait_time[i]--;
     }
 }
 
+/**
+ * AVX2 version of update_turnaround_times_columns()
+ * @param current_time Current simulation time
+ */
+__attribute__((target("avx2")))
+static void update_turnaround_times_avx2(Simulator* sim, SimTime current_time) {
+    increment_arrived_avx2(sim, sim->columns.turnaround_time, current_time);
+}
+#endif
+
 /**
  * Checks if all processes have completed execution
+ * O(1) with incremental accounting, otherwise a scan of the process table
+ * or of the completion bitset
+ * @param mode Accounting mode of the tick-engine variant
  * @return true if all processes are complete, false otherwise
  */
-bool all_processes_complete() {
-    for (int i = 0; i < num_processes; i++) {
-        if (!processes[i].completed) {
+static TICK_INLINE bool all_processes_complete(Simulator* sim, TickMode mode) {
+    if (mode == TICK_INCREMENTAL) {
+        return sim->completed_count == sim->num_processes;
+    }
+    if (mode == TICK_SCAN_SOA) {
+        for (int base = 0; base + 64 <= sim->num_processes; base += 64) {
+            if (~sim->columns.completed[base / 64]) {
+                return false;
+            }
+        }
+        // Bits past the last process are never set
+        int tail = sim->num_processes % 64;
+        return tail == 0 || sim->columns.completed[sim->num_processes / 64] == (UINT64_C(1) << tail) - 1;
+    }
+    for (int i = 0; i < sim->num_processes; i++) {
+        if (!sim->processes[i].completed) {
             return false;  // At least one process is not completed
         }
     }
@@ -284,74 +5498,373 @@ bool all_processes_complete() {
 
 /**
  * Prints final statistics for all processes
- * Includes individual process stats and overall averages
+ * Includes individual process stats, unless only a summary was requested,
+ * and overall averages
  */
-void print_final_stats() {
-    double total_wait_time = 0;         // Sum of wait times for all processes
-    double total_turnaround_time = 0;   // Sum of turnaround times for all processes
+void print_final_stats(Simulator* sim) {
+    STATS_TIMER_START(report_start);
+    TimeTotal total_wait_time = 0;      // Sum of wait times for all processes
+    TimeTotal total_turnaround_time = 0; // Sum of turnaround times for all processes
 
     // Iterate over all processes to print their statistics
-    for (int i = 0; i < num_processes; i++) {
-        printf("\nP%d\n", i);
-        printf("\tWaiting time:\t\t%3d\n", processes[i].wait_time);
-        printf("\tTurnaround time:\t%3d\n", processes[i].turnaround_time);
+    for (int i = 0; i < sim->num_processes; i++) {
+        if (sim->trace_level != TRACE_SUMMARY) {
+            output_text(&sim->output, "\nP");
+            output_int(&sim->output, sim->processes[i].id, 0);
+            output_text(&sim->output, "\n\tWaiting time:\t\t");
+            output_int(&sim->output, sim->processes[i].wait_time, 3);
+            output_text(&sim->output, "\n\tTurnaround time:\t");
+            output_int(&sim->output, sim->processes[i].turnaround_time, 3);
+            output_text(&sim->output, "\n");
+        }
         
-        total_wait_time += processes[i].wait_time;
-        total_turnaround_time += processes[i].turnaround_time;
+        total_wait_time += sim->processes[i].wait_time;
+        total_turnaround_time += sim->processes[i].turnaround_time;
     }
+    output_flush(&sim->output);
+
     // Print average statistics
-    printf("\nTotal average waiting time:\t%.1f\n", total_wait_time / num_processes);
-    printf("Total average turnaround time:\t%.1f\n", total_turnaround_time / num_processes);
+    printf("\nTotal average waiting time:\t%.1f\n", (double)total_wait_time / sim->num_processes);
+    printf("Total average turnaround time:\t%.1f\n", (double)total_turnaround_time / sim->num_processes);
+
+    // Share of the makespan each core spent executing
+    if (sim->num_cores > 1) {
+        RunSummary summary;
+        summarize_run(sim, &summary);
+        printf("\n");
+        for (int c = 0; c < sim->num_cores; c++) {
+            const CoreStats* stats = &sim->core_stats[c];
+            printf("Core %d utilization:\t%5.1f%% (busy %lld, migration %lld, dispatches %d, steals %d)\n",
+                c, summary.makespan > 0 ? 100.0 * stats->busy_time / summary.makespan : 0.0,
+                (long long)stats->busy_time, (long long)stats->migration_time, stats->dispatches, stats->steals);
+        }
+    }
+    fflush(stdout);
+    STATS_TIMER_STOP(sim, report_start, report_seconds);
 }
 
 /**
- * Main function - Entry point of the program
- * Handles command line arguments and runs selected scheduling algorithm
+ * Prints the 50th, 95th, 99th and 99.9th percentiles and the maximum of the
+ * waiting, turnaround and response times, see simulator_percentile()
  */
-int main(int argc, char *argv[]) {
-    // Check for minimum number of arguments
-    if (argc < 3) {
-        printf("Usage: %s [-f|-s|-r <quantum>] <input_file>\n", argv[0]);
-        return 1;
+void print_percentiles(const Simulator* sim) {
+    static const char* labels[NUM_METRICS] = { "Waiting time:\t", "Turnaround time:", "Response time:\t" };
+
+    printf("\nPercentiles:\t\t    p50     p95     p99   p99.9     max\n");
+    for (int m = 0; m < NUM_METRICS; m++) {
+        printf("%s\t%7lld %7lld %7lld %7lld %7lld\n", labels[m],
+               (long long)simulator_percentile(sim, (Metric)m, 0.5), (long long)simulator_percentile(sim, (Metric)m, 0.95),
+               (long long)simulator_percentile(sim, (Metric)m, 0.99), (long long)simulator_percentile(sim, (Metric)m, 0.999),
+               (long long)sim->sketches[m].max);
+    }
+}
+
+/**
+ * Orders two processes in the virtual runtime tree
+ * Ties go to the earlier arrival, then to the lower ID
+ * @param tree Tree holding the virtual runtimes
+ * @param a Index of the first process
+ * @param b Index of the second process
+ * @return true if a comes before b
+ */
+static bool tree_before(const VruntimeTree* tree, int a, int b) {
+    if (tree->nodes[a].vruntime != tree->nodes[b].vruntime) {
+        return tree->nodes[a].vruntime < tree->nodes[b].vruntime;
+    }
+    if (tree->processes[a].arrival_time != tree->processes[b].arrival_time) {
+        return tree->processes[a].arrival_time < tree->processes[b].arrival_time;
+    }
+    return tree->processes[a].id < tree->processes[b].id;
+}
+
+/**
+ * Allocates an empty tree with one node per process
+ * @param tree Tree to initialize
+ * @param capacity Number of processes in the process table
+ * @param processes Process table the nodes refer to
+ */
+static void tree_init(VruntimeTree* tree, int capacity, const Process* processes) {
+    // The extra node is the shared black sentinel
+    tree->nodes = malloc(((size_t)capacity + 1) * sizeof(TreeNode));
+    if (!tree->nodes) {
+        printf("Error: Out of memory\n");
+        exit(1);
     }
+    tree->nil = capacity;
+    tree->nodes[tree->nil].red = false;
+    tree->root = tree->nil;
+    tree->leftmost = tree->nil;
+    tree->size = 0;
+    tree->processes = processes;
+    for (int i = 0; i < capacity; i++) {
+        tree->nodes[i].vruntime = 0;
+    }
+}
 
-    const char* algorithm = argv[1];  // Scheduling algorithm option
-    const char* filename;             // Input file name
-    int quantum = 0;                  // Time quantum for Round Robin
+/**
+ * Releases the storage of a tree
+ * @param tree Tree to free
+ */
+static void tree_free(VruntimeTree* tree) {
+    free(tree->nodes);
+    tree->nodes = NULL;
+    tree->size = 0;
+}
 
-    // Handle Round Robin specific argument
-    if (strcmp(algorithm, "-r") == 0) {
-        if (argc < 4) {
-            printf("Error: Round Robin requires a time quantum\n");
-            return 1;
+/**
+ * Rotates the subtree rooted at x to the left
+ * @param tree Tree to restructure
+ * @param x Node whose right child takes its place
+ */
+static void tree_rotate_left(VruntimeTree* tree, int x) {
+    TreeNode* n = tree->nodes;
+    int y = n[x].right;
+    n[x].right = n[y].left;
+    if (n[y].left != tree->nil) {
+        n[n[y].left].parent = x;
+    }
+    n[y].parent = n[x].parent;
+    if (n[x].parent == tree->nil) {
+        tree->root = y;
+    } else if (x == n[n[x].parent].left) {
+        n[n[x].parent].left = y;
+    } else {
+        n[n[x].parent].right = y;
+    }
+    n[y].left = x;
+    n[x].parent = y;
+}
+
+/**
+ * Rotates the subtree rooted at x to the right
+ * @param tree Tree to restructure
+ * @param x Node whose left child takes its place
+ */
+static void tree_rotate_right(VruntimeTree* tree, int x) {
+    TreeNode* n = tree->nodes;
+    int y = n[x].left;
+    n[x].left = n[y].right;
+    if (n[y].right != tree->nil) {
+        n[n[y].right].parent = x;
+    }
+    n[y].parent = n[x].parent;
+    if (n[x].parent == tree->nil) {
+        tree->root = y;
+    } else if (x == n[n[x].parent].right) {
+        n[n[x].parent].right = y;
+    } else {
+        n[n[x].parent].left = y;
+    }
+    n[y].right = x;
+    n[x].parent = y;
+}
+
+/**
+ * Inserts a process, keyed by its current virtual runtime
+ * @param tree Tree to insert into
+ * @param index Index of the process, not already in the tree
+ */
+static void tree_insert(VruntimeTree* tree, int index) {
+    TreeNode* n = tree->nodes;
+    int parent = tree->nil;
+    int node = tree->root;
+    bool leftmost = true;   // Whether the path only turned left
+
+    while (node != tree->nil) {
+        parent = node;
+        if (tree_before(tree, index, node)) {
+            node = n[node].left;
+        } else {
+            node = n[node].right;
+            leftmost = false;
         }
-        // Parse quantum from command line argument
-        quantum = atoi(argv[2]);
-        if (quantum <= 0) {
-            printf("Error: Time quantum must be positive\n");
-            return 1;
+    }
+    n[index].parent = parent;
+    n[index].left = tree->nil;
+    n[index].right = tree->nil;
+    n[index].red = true;
+    if (parent == tree->nil) {
+        tree->root = index;
+    } else if (tree_before(tree, index, parent)) {
+        n[parent].left = index;
+    } else {
+        n[parent].right = index;
+    }
+    if (leftmost) {
+        tree->leftmost = index;
+    }
+    tree->size++;
+
+    // Restore the red-black properties on the way up
+    int x = index;
+    while (n[n[x].parent].red) {
+        int p = n[x].parent;
+        int g = n[p].parent;
+        if (p == n[g].left) {
+            int uncle = n[g].right;
+            if (n[uncle].red) {
+                n[p].red = false;
+                n[uncle].red = false;
+                n[g].red = true;
+                x = g;
+            } else {
+                if (x == n[p].right) {
+                    x = p;
+                    tree_rotate_left(tree, x);
+                    p = n[x].parent;
+                }
+                n[p].red = false;
+                n[g].red = true;
+                tree_rotate_right(tree, g);
+            }
+        } else {
+            int uncle = n[g].left;
+            if (n[uncle].red) {
+                n[p].red = false;
+                n[uncle].red = false;
+                n[g].red = true;
+                x = g;
+            } else {
+                if (x == n[p].left) {
+                    x = p;
+                    tree_rotate_right(tree, x);
+                    p = n[x].parent;
+                }
+                n[p].red = false;
+                n[g].red = true;
+                tree_rotate_left(tree, g);
+            }
         }
-        filename = argv[3];  // Input file name is the fourth argument
+    }
+    n[tree->root].red = false;
+}
+
+/**
+ * Replaces the subtree rooted at u with the one rooted at v
+ * @param tree Tree to restructure
+ * @param u Node to unlink
+ * @param v Node taking its place, may be the sentinel
+ */
+static void tree_transplant(VruntimeTree* tree, int u, int v) {
+    TreeNode* n = tree->nodes;
+    if (n[u].parent == tree->nil) {
+        tree->root = v;
+    } else if (u == n[n[u].parent].left) {
+        n[n[u].parent].left = v;
     } else {
-        filename = argv[2];  // Input file name is the third argument
+        n[n[u].parent].right = v;
     }
+    n[v].parent = n[u].parent;
+}
+
+/**
+ * Removes a process from the tree
+ * @param tree Tree to remove from
+ * @param index Index of a process in the tree
+ */
+static void tree_remove(VruntimeTree* tree, int index) {
+    TreeNode* n = tree->nodes;
+    int z = index;
+    int y = z;
+    bool removed_red = n[y].red;
+    int x;
 
-    // Read processes from input file
-    read_input_file(filename);
+    // The leftmost node has no left child, so its successor is the
+    // leftmost node of its right subtree or else its parent
+    if (z == tree->leftmost) {
+        if (n[z].right != tree->nil) {
+            int next = n[z].right;
+            while (n[next].left != tree->nil) {
+                next = n[next].left;
+            }
+            tree->leftmost = next;
+        } else {
+            tree->leftmost = n[z].parent;
+        }
+    }
 
-    // Run the selected scheduling algorithm
-    if (strcmp(algorithm, "-f") == 0) {
-        simulate_fcfs();
-    } else if (strcmp(algorithm, "-s") == 0) {
-        simulate_sjf();
-    } else if (strcmp(algorithm, "-r") == 0) {
-        simulate_round_robin(quantum);
+    if (n[z].left == tree->nil) {
+        x = n[z].right;
+        tree_transplant(tree, z, n[z].right);
+    } else if (n[z].right == tree->nil) {
+        x = n[z].left;
+        tree_transplant(tree, z, n[z].left);
     } else {
-        printf("Error: Invalid algorithm option\n");
-        return 1;
+        y = n[z].right;
+        while (n[y].left != tree->nil) {
+            y = n[y].left;
+        }
+        removed_red = n[y].red;
+        x = n[y].right;
+        if (n[y].parent == z) {
+            n[x].parent = y;
+        } else {
+            tree_transplant(tree, y, n[y].right);
+            n[y].right = n[z].right;
+            n[n[y].right].parent = y;
+        }
+        tree_transplant(tree, z, y);
+        n[y].left = n[z].left;
+        n[n[y].left].parent = y;
+        n[y].red = n[z].red;
     }
+    tree->size--;
 
-    // Print final statistics
-    print_final_stats();
-    return 0;
+    if (removed_red) {
+        return;
+    }
+    // Removing a black node shortened one path: push the extra black up
+    while (x != tree->root && !n[x].red) {
+        int p = n[x].parent;
+        if (x == n[p].left) {
+            int w = n[p].right;
+            if (n[w].red) {
+                n[w].red = false;
+                n[p].red = true;
+                tree_rotate_left(tree, p);
+                w = n[p].right;
+            }
+            if (!n[n[w].left].red && !n[n[w].right].red) {
+                n[w].red = true;
+                x = p;
+            } else {
+                if (!n[n[w].right].red) {
+                    n[n[w].left].red = false;
+                    n[w].red = true;
+                    tree_rotate_right(tree, w);
+                    w = n[p].right;
+                }
+                n[w].red = n[p].red;
+                n[p].red = false;
+                n[n[w].right].red = false;
+                tree_rotate_left(tree, p);
+                x = tree->root;
+            }
+        } else {
+            int w = n[p].left;
+            if (n[w].red) {
+                n[w].red = false;
+                n[p].red = true;
+                tree_rotate_right(tree, p);
+                w = n[p].left;
+            }
+            if (!n[n[w].right].red && !n[n[w].left].red) {
+                n[w].red = true;
+                x = p;
+            } else {
+                if (!n[n[w].left].red) {
+                    n[n[w].right].red = false;
+                    n[w].red = true;
+                    tree_rotate_left(tree, w);
+                    w = n[p].left;
+                }
+                n[w].red = n[p].red;
+                n[p].red = false;
+                n[n[w].left].red = false;
+                tree_rotate_right(tree, p);
+                x = tree->root;
+            }
+        }
+    }
+    n[x].red = false;
 }
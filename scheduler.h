@@ -0,0 +1,200 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Simulation times and durations: 32-bit by default, which keeps the process
+// table and the sweep columns dense, or 64-bit in a build with SCHEDULER_TIME64
+// (make TIME64=1) for horizons past 2^31 time units
+#ifdef SCHEDULER_TIME64
+typedef int64_t SimTime;
+#define SIM_TIME_MAX INT64_MAX
+#else
+typedef int32_t SimTime;
+#define SIM_TIME_MAX INT32_MAX
+#endif
+
+// Most levels a multi-level feedback queue can have, one bit each in its bitmap
+#define MLFQ_MAX_LEVELS 64
+
+// Range of process priorities, as Unix nice values: lower runs first
+#define PRIORITY_HIGHEST (-20)
+#define PRIORITY_LOWEST 19
+
+// Structure to hold process information
+typedef struct {
+    int id;                 // Process ID
+    SimTime burst_time;     // Total CPU time required over all CPU bursts
+    SimTime remaining_time; // Remaining CPU time of the current CPU burst
+    SimTime arrival_time;   // Arrival time
+    SimTime wait_time;      // Total time the process has waited
+    SimTime turnaround_time; // Total time from arrival to completion
+    SimTime start_time;     // Time the process first executed (-1 until dispatched)
+    SimTime completion_time; // Time unit after the last one the process executed
+    int priority;           // Nice value weighting the CFS share of the processor, 0 by default
+    int partition;          // Independent partition of the workload, such as a cluster or tenant, 0 by default
+    SimTime io_time;        // Total time spent blocked on I/O
+    int first_phase;        // Index of the first I/O burst in the simulator's phase table
+    int num_phases;         // Number of I/O bursts, each followed by another CPU burst
+    int phase;              // I/O bursts started so far
+    SimTime pending_time;   // CPU time of the bursts after the current one
+    SimTime blocked_time;   // I/O time of the bursts started so far
+    bool completed;         // Flag to indicate if process has completed execution
+} Process;
+
+// Amount of output produced by a simulation
+typedef enum {
+    TRACE_SUMMARY,  // Averages only: no trace and no per-process statistics
+    TRACE_OFF,      // Final statistics only
+    TRACE_SEGMENTS, // One line per contiguous run of a process
+    TRACE_FULL      // One line per time unit
+} TraceLevel;
+
+// Simulation engines
+typedef enum {
+    ENGINE_TICK,    // Reference engine: advances one time unit per iteration
+    ENGINE_EVENT,   // Discrete-event engine: jumps between arrivals, completions and quantum expiries
+    ENGINE_ANALYTIC // Closed form for FCFS without I/O: a scan over the completion times, without a trace
+} Engine;
+
+// Scheduling policies
+typedef enum {
+    POLICY_FCFS,    // First Come First Served
+    POLICY_SJF,     // Preemptive Shortest Job First
+    POLICY_RR,      // Round Robin
+    POLICY_MLFQ,    // Multi-Level Feedback Queue
+    POLICY_CFS      // Completely Fair Scheduler
+} Policy;
+
+// Memory layouts for the per-tick sweeps
+typedef enum {
+    LAYOUT_AOS,     // Sweep the process table directly
+    LAYOUT_SOA      // Sweep contiguous per-field columns and a completion bitset
+} Layout;
+
+// Accounting modes for wait and turnaround times
+typedef enum {
+    ACCOUNTING_SCAN,        // Update every process on each time unit
+    ACCOUNTING_INCREMENTAL  // Keep running counts and derive times from timestamps
+} Accounting;
+
+// Distributions of generated burst times and of the gaps between arrivals
+typedef enum {
+    DIST_CONSTANT,      // Always the mean
+    DIST_UNIFORM,       // Uniform between 0 and twice the mean
+    DIST_EXPONENTIAL,   // Exponential; exponential gaps make arrivals a Poisson process
+    DIST_PARETO         // Pareto with tail index 1.5: heavy-tailed, with infinite variance
+} Distribution;
+
+// Synthetic workload drawn by generate_workload() and write_workload()
+typedef struct {
+    int count;                          // Number of processes
+    Distribution burst_distribution;    // Distribution of CPU bursts
+    double mean_burst;                  // Mean CPU burst, at least 1
+    Distribution arrival_distribution;  // Distribution of the gaps between arrivals
+    double mean_interarrival;           // Mean gap between arrivals, 0 for all at time 0
+    uint64_t seed;                      // Seed of the generator; equal specs give equal workloads
+} WorkloadSpec;
+
+// Per-process times summarized by percentiles
+typedef enum {
+    METRIC_WAIT,        // Waiting time
+    METRIC_TURNAROUND,  // Turnaround time
+    METRIC_RESPONSE,    // Time from arrival to first execution
+    NUM_METRICS
+} Metric;
+
+// Aggregate results of one simulation
+typedef struct {
+    double average_wait_time;       // Mean wait time over all processes
+    double average_turnaround_time; // Mean turnaround time over all processes
+    SimTime makespan;               // Completion time of the last process
+    int64_t segments;               // Segments run by the event engine, 0 for the tick engine
+} RunSummary;
+
+// Work done by one core during a multi-core simulation
+typedef struct {
+    SimTime busy_time;      // Time units spent executing processes
+    SimTime migration_time; // Time units spent moving stolen processes onto the core
+    int dispatches;         // Segments started on the core
+    int steals;             // Processes taken from the ready queues of other cores
+} CoreStats;
+
+// Instrumentation of the last run, kept only when the library is built with SCHEDULER_STATS
+typedef struct {
+    int64_t context_switches;   // Runs of a different process than the processor ran last
+    int64_t preemptions;        // Context switches away from a process with its CPU burst unfinished
+    int max_ready;              // Most processes arrived and not completed or blocked at once
+    int64_t scan_iterations;    // Processes examined by the tick engine's SJF selection scans
+    int64_t ticks;              // Time units stepped by the tick engine
+    int64_t events;             // Arrivals and I/O completions, plus the segments run by the event engine
+    int64_t shard_steals;       // Shards a sharded run took from the deque of another worker
+    double load_seconds;        // Wall time spent loading or generating the workload
+    double simulate_seconds;    // Wall time spent in the last run_simulation() or run_stream()
+    double report_seconds;      // Wall time spent in print_final_stats()
+} SimulatorStats;
+
+// How a simulator runs and how much it prints
+typedef struct {
+    Engine engine;          // Simulation engine
+    Accounting accounting;  // How wait and turnaround times are maintained
+    Layout layout;          // Layout swept by scan accounting
+    bool allow_simd;        // Whether vector sweep kernels may be used
+    TraceLevel trace_level; // Amount of output to produce
+    int num_cores;          // Number of cores, each with its own ready queue
+    bool work_stealing;     // Whether idle cores take work queued on other cores
+    int migration_cost;     // Time units a stolen process takes to start on its new core
+    int mlfq_levels;        // Number of MLFQ priority levels
+    int mlfq_quanta[MLFQ_MAX_LEVELS]; // Time slice of each MLFQ level, from the highest priority down
+    int mlfq_boost_period;  // Time units between MLFQ priority boosts, 0 for none
+    int cfs_latency;        // Time units in which CFS aims to run every runnable process once
+    int cfs_min_granularity; // Shortest CFS slice when many processes share the latency
+    int num_threads;        // Threads the analytic engine splits large runs across, 0 for one per online CPU
+} SimulatorOptions;
+
+// Process table and state of one simulation; independent simulators may be
+// used from different threads at the same time
+typedef struct Simulator Simulator;
+
+void simulator_default_options(SimulatorOptions* options);
+const char* simulator_check_options(const SimulatorOptions* options);
+Simulator* simulator_create(const SimulatorOptions* options);
+void simulator_destroy(Simulator* sim);
+int read_input_file(Simulator* sim, const char* filename);
+int read_input_data(Simulator* sim, const char* data, size_t length);
+void reserve_processes(Simulator* sim, int count);
+Process* add_process(Simulator* sim);
+void add_io_burst(Simulator* sim, Process* p, SimTime io_time, SimTime burst_time);
+void simulator_copy_workload(Simulator* sim, const Simulator* source);
+void workload_default_spec(WorkloadSpec* spec);
+const char* workload_check_spec(const WorkloadSpec* spec);
+void generate_workload(Simulator* sim, const WorkloadSpec* spec);
+bool write_workload(const WorkloadSpec* spec, FILE* file);
+bool write_workload_columns(const Simulator* sim, FILE* file, bool checksummed);
+int simulator_num_processes(const Simulator* sim);
+const Process* simulator_process(const Simulator* sim, int index);
+int simulator_num_cores(const Simulator* sim);
+const CoreStats* simulator_core_stats(const Simulator* sim, int core);
+const SimulatorStats* simulator_stats(const Simulator* sim);
+const char* simulator_check_policy(const Simulator* sim, Policy policy);
+void run_simulation(Simulator* sim, Policy policy, int quantum);
+const char* simulator_check_stream(const Simulator* sim, Policy policy);
+int run_stream(Simulator* sim, Policy policy, int quantum, int fd, int report_interval, RunSummary* summary);
+const char* simulator_check_shards(const Simulator* sim, Policy policy);
+int run_sharded(Simulator* sim, Policy policy, int quantum, int num_threads);
+void summarize_run(const Simulator* sim, RunSummary* summary);
+SimTime simulator_percentile(const Simulator* sim, Metric metric, double quantile);
+void print_final_stats(Simulator* sim);
+void print_percentiles(const Simulator* sim);
+bool binary_trace_open(Simulator* sim, const char* filename);
+void binary_trace_close(Simulator* sim);
+void simulator_set_checkpoint(Simulator* sim, const char* filename, double interval);
+int simulator_checkpoints_written(const Simulator* sim);
+const char* simulator_resume(Simulator* sim, const char* filename, Policy* policy);
+void simulator_set_snapshots(Simulator* sim, int interval);
+int run_what_if(Simulator* sim, int id, SimTime burst_time, RunSummary* summary);
+int dump_binary_trace(const char* filename);
+
+#endif
@@ -0,0 +1,834 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "server.h"
+
+// Longest request line, including its newline
+#define QUERY_LINE_SIZE 4096
+// Longest response line
+#define RESPONSE_SIZE 256
+// Connections the listening socket queues before they are accepted
+#define LISTEN_BACKLOG 128
+
+// File a workload was read from, recognized again without reading it
+typedef struct {
+    dev_t device;               // Device holding the file
+    ino_t inode;                // Inode of the file
+    off_t size;                 // Length of the file
+    struct timespec modified;   // Last modification of the contents
+    struct timespec changed;    // Last change of the contents or the inode
+} FileIdentity;
+
+// Result of simulating a cached workload with one policy
+typedef struct {
+    Policy policy;          // Scheduling policy
+    int quantum;            // Time quantum for Round Robin, 0 otherwise
+    RunSummary summary;     // Averages and makespan
+} CachedResult;
+
+// Parsed workload kept by the server, keyed by the hash of the file contents
+typedef struct {
+    uint64_t hash;          // FNV-1a hash of the contents
+    size_t size;            // Length of the contents
+    FileIdentity identity;  // File the contents were last read from
+    Simulator* workload;    // Parsed processes, shared read-only; NULL while being parsed
+    int malformed;          // Malformed lines skipped when parsing, -1 for a damaged columnar file
+    int users;              // Queries using the entry, which keep it from being evicted
+    uint64_t last_used;     // Value of the server's use counter when last used
+    CachedResult* results;  // Results of the policies simulated so far
+    int num_results;        // Entries used in results
+    int result_capacity;    // Entries results can hold without growing
+} CachedWorkload;
+
+// Client connection; slots are reused once closed
+typedef struct {
+    int fd;                 // Socket of the connection, -1 for a free slot
+    char buffer[QUERY_LINE_SIZE]; // Bytes received and not yet queued as a query
+    size_t length;          // Bytes used in buffer
+    bool busy;              // Whether a worker is answering one of its queries
+    bool closing;           // Whether the client hung up while a query was being answered
+} Connection;
+
+// Request line waiting for a worker
+typedef struct {
+    int connection;             // Index of the connection that sent it
+    int fd;                     // Socket to answer on
+    char line[QUERY_LINE_SIZE]; // Request, without its newline
+} Query;
+
+// State shared by the dispatcher and the workers
+typedef struct {
+    SimulatorOptions options;   // Options every query is simulated with
+    int listen_fd;              // Listening socket
+    int wake[2];                // Pipe the workers write to when a connection becomes idle
+    pthread_mutex_t lock;       // Guards the fields below
+    pthread_cond_t work;        // Signalled when a query is queued or the server stops
+    pthread_cond_t parsed;      // Signalled when a workload has been parsed
+    Query* queries;             // Ring buffer of queued queries
+    int query_head;             // Slot of the oldest queued query
+    int num_queries;            // Number of queued queries
+    int query_capacity;         // Number of slots in queries
+    Connection* connections;    // Connection slots
+    int num_connections;        // Slots in use or free
+    CachedWorkload** cache;     // Cached workloads
+    int cache_count;            // Workloads in the cache
+    int cache_size;             // Workloads kept before the least recently used idle one is evicted
+    uint64_t uses;              // Workload lookups so far, ordering the LRU eviction
+    bool stopping;              // Whether the workers should exit
+} Server;
+
+// Worker thread and the simulator it runs queries on
+typedef struct {
+    Server* server;         // Shared state
+    Simulator* sim;         // Private simulator holding a copy of the last workload used
+    uint64_t loaded_hash;   // Hash of the contents copied into sim
+    size_t loaded_size;     // Length of the contents copied into sim, with the hash
+    bool loaded;            // Whether sim holds a workload
+} ServerWorker;
+
+// Write end of the dispatcher's wake-up pipe, for the signal handler
+static int stop_fd = -1;
+// Set by SIGINT and SIGTERM
+static volatile sig_atomic_t stop_requested = 0;
+
+// Function prototypes
+static void handle_stop(int signum);
+static void* server_worker(void* arg);
+static void answer_query(ServerWorker* worker, char* line, char* response);
+static bool parse_query(char* line, Policy* policy, int* quantum, const char** path);
+static CachedWorkload* acquire_workload(Server* server, const char* path, const char** problem);
+static void release_workload(Server* server, CachedWorkload* entry);
+static CachedWorkload* add_cache_entry(Server* server);
+static bool same_identity(const FileIdentity* a, const FileIdentity* b);
+static char* read_whole_file(const char* path, size_t* size, FileIdentity* identity);
+static uint64_t hash_contents(const char* data, size_t size);
+static int add_connection(Server* server, int fd);
+static void close_connection(Server* server, int c);
+static void queue_next_query(Server* server, int c);
+static bool send_all(int fd, const char* data, size_t length);
+
+/**
+ * Serves simulation queries on a Unix socket until SIGINT or SIGTERM
+ * Each request is a line "<policy> <path>", where the policy is f, s, m, c
+ * or r<quantum> as on the command line, answered with a line
+ * "ok,<average wait>,<average turnaround>,<makespan>,<malformed lines>" or
+ * "error,<message>". Parsed workloads are cached by the hash of their
+ * contents, together with the results of every policy run on them; a file
+ * whose identity, size and timestamps are unchanged is not read again.
+ * Queries from all connections are queued for a pool of workers, while
+ * each connection's own queries are answered in order
+ * @param socket_path Path to create the socket at; a stale socket there is replaced
+ * @param options Options every query is simulated with
+ * @param num_threads Number of worker threads
+ * @param cache_size Workloads to keep cached
+ * @return 0 after a clean shutdown, 1 if the socket cannot be set up
+ */
+int run_server(const char* socket_path, const SimulatorOptions* options, int num_threads, int cache_size) {
+    Server server;
+    memset(&server, 0, sizeof(server));
+    server.options = *options;
+    server.options.trace_level = TRACE_SUMMARY;
+    server.cache_size = cache_size;
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        printf("Error: Socket path %s is too long\n", socket_path);
+        return 1;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    // Replace a socket left behind by a server that did not shut down
+    struct stat st;
+    if (lstat(socket_path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(socket_path);
+    }
+    server.listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (server.listen_fd < 0 ||
+        bind(server.listen_fd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(server.listen_fd, LISTEN_BACKLOG) != 0) {
+        printf("Error: Could not listen on %s\n", socket_path);
+        if (server.listen_fd >= 0) {
+            close(server.listen_fd);
+        }
+        return 1;
+    }
+    if (pipe(server.wake) != 0) {
+        printf("Error: Could not listen on %s\n", socket_path);
+        close(server.listen_fd);
+        unlink(socket_path);
+        return 1;
+    }
+    fcntl(server.wake[0], F_SETFL, O_NONBLOCK);
+    fcntl(server.wake[1], F_SETFL, O_NONBLOCK);
+
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.work, NULL);
+    pthread_cond_init(&server.parsed, NULL);
+    server.cache = malloc((size_t)cache_size * sizeof(CachedWorkload*));
+    ServerWorker* workers = calloc(num_threads, sizeof(ServerWorker));
+    pthread_t* threads = malloc((size_t)num_threads * sizeof(pthread_t));
+    if (!server.cache || !workers || !threads) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+
+    stop_fd = server.wake[1];
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_stop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    for (int t = 0; t < num_threads; t++) {
+        workers[t].server = &server;
+        workers[t].sim = simulator_create(&server.options);
+        if (pthread_create(&threads[t], NULL, server_worker, &workers[t]) != 0) {
+            printf("Error: Could not start worker thread\n");
+            exit(1);
+        }
+    }
+    fprintf(stderr, "Serving on %s with %d worker thread%s\n", socket_path, num_threads, num_threads == 1 ? "" : "s");
+
+    // Dispatch loop: accept connections, and queue the next complete line of
+    // every connection that has no query being answered
+    struct pollfd* polled = NULL;
+    int* polled_connections = NULL;
+    int polled_capacity = 0;
+    while (!stop_requested) {
+        pthread_mutex_lock(&server.lock);
+        for (int c = 0; c < server.num_connections; c++) {
+            if (server.connections[c].fd >= 0 && !server.connections[c].busy) {
+                queue_next_query(&server, c);
+            }
+        }
+        if (polled_capacity < server.num_connections + 2) {
+            polled_capacity = (server.num_connections + 2) * 2;
+            polled = realloc(polled, (size_t)polled_capacity * sizeof(struct pollfd));
+            polled_connections = realloc(polled_connections, (size_t)polled_capacity * sizeof(int));
+            if (!polled || !polled_connections) {
+                printf("Error: Out of memory\n");
+                exit(1);
+            }
+        }
+        int num_polled = 2;
+        polled[0].fd = server.listen_fd;
+        polled[0].events = POLLIN;
+        polled[1].fd = server.wake[0];
+        polled[1].events = POLLIN;
+        for (int c = 0; c < server.num_connections; c++) {
+            const Connection* connection = &server.connections[c];
+            if (connection->fd >= 0 && !connection->busy) {
+                polled[num_polled].fd = connection->fd;
+                polled[num_polled].events = POLLIN;
+                polled_connections[num_polled] = c;
+                num_polled++;
+            }
+        }
+        pthread_mutex_unlock(&server.lock);
+
+        if (poll(polled, num_polled, -1) < 0) {
+            continue;   // Interrupted by a signal
+        }
+        if (polled[1].revents & POLLIN) {
+            char drain[64];
+            while (read(server.wake[0], drain, sizeof(drain)) > 0) {
+            }
+        }
+        if (polled[0].revents & POLLIN) {
+            int fd = accept(server.listen_fd, NULL, NULL);
+            if (fd >= 0) {
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+                pthread_mutex_lock(&server.lock);
+                add_connection(&server, fd);
+                pthread_mutex_unlock(&server.lock);
+            }
+        }
+
+        pthread_mutex_lock(&server.lock);
+        for (int i = 2; i < num_polled; i++) {
+            if (polled[i].revents == 0) {
+                continue;
+            }
+            int c = polled_connections[i];
+            Connection* connection = &server.connections[c];
+            ssize_t got = read(connection->fd, connection->buffer + connection->length,
+                               QUERY_LINE_SIZE - connection->length);
+            if (got <= 0) {
+                if (got < 0 && (errno == EINTR || errno == EAGAIN)) {
+                    continue;
+                }
+                close_connection(&server, c);
+                continue;
+            }
+            connection->length += (size_t)got;
+            queue_next_query(&server, c);
+        }
+        pthread_mutex_unlock(&server.lock);
+    }
+
+    // Let the workers finish the queries they are answering, then close up
+    pthread_mutex_lock(&server.lock);
+    server.stopping = true;
+    pthread_cond_broadcast(&server.work);
+    pthread_mutex_unlock(&server.lock);
+    for (int t = 0; t < num_threads; t++) {
+        pthread_join(threads[t], NULL);
+        simulator_destroy(workers[t].sim);
+    }
+    for (int c = 0; c < server.num_connections; c++) {
+        if (server.connections[c].fd >= 0) {
+            close(server.connections[c].fd);
+        }
+    }
+    for (int i = 0; i < server.cache_count; i++) {
+        simulator_destroy(server.cache[i]->workload);
+        free(server.cache[i]->results);
+        free(server.cache[i]);
+    }
+    close(server.listen_fd);
+    unlink(socket_path);
+    stop_fd = -1;
+    close(server.wake[0]);
+    close(server.wake[1]);
+    pthread_cond_destroy(&server.parsed);
+    pthread_cond_destroy(&server.work);
+    pthread_mutex_destroy(&server.lock);
+    free(polled);
+    free(polled_connections);
+    free(server.connections);
+    free(server.queries);
+    free(server.cache);
+    free(threads);
+    free(workers);
+    return 0;
+}
+
+/**
+ * Signal handler for SIGINT and SIGTERM: asks the dispatcher to shut down
+ * @param signum Signal received
+ */
+static void handle_stop(int signum) {
+    (void)signum;
+    stop_requested = 1;
+    if (stop_fd >= 0) {
+        char byte = 0;
+        ssize_t ignored = write(stop_fd, &byte, 1);
+        (void)ignored;
+    }
+}
+
+/**
+ * Thread body of a server worker
+ * Answers queued queries until the server stops, then wakes the dispatcher
+ * so the connection is polled again for its next query
+ * @param arg The worker's ServerWorker
+ * @return NULL
+ */
+static void* server_worker(void* arg) {
+    ServerWorker* worker = arg;
+    Server* server = worker->server;
+
+    pthread_mutex_lock(&server->lock);
+    for (;;) {
+        while (server->num_queries == 0 && !server->stopping) {
+            pthread_cond_wait(&server->work, &server->lock);
+        }
+        if (server->stopping) {
+            break;
+        }
+        Query query = server->queries[server->query_head];
+        server->query_head = (server->query_head + 1) % server->query_capacity;
+        server->num_queries--;
+        pthread_mutex_unlock(&server->lock);
+
+        char response[RESPONSE_SIZE];
+        answer_query(worker, query.line, response);
+        bool sent = send_all(query.fd, response, strlen(response));
+
+        pthread_mutex_lock(&server->lock);
+        Connection* connection = &server->connections[query.connection];
+        connection->busy = false;
+        if (!sent || connection->closing) {
+            close_connection(server, query.connection);
+        }
+        char byte = 0;
+        ssize_t ignored = write(server->wake[1], &byte, 1);
+        (void)ignored;
+    }
+    pthread_mutex_unlock(&server->lock);
+    return NULL;
+}
+
+/**
+ * Answers one query, simulating the workload unless the result is cached
+ * @param line Request without its newline; modified while parsing
+ * @param response Receives the response line, with its newline
+ */
+static void answer_query(ServerWorker* worker, char* line, char* response) {
+    Server* server = worker->server;
+    Policy policy;
+    int quantum;
+    const char* path;
+    if (!parse_query(line, &policy, &quantum, &path)) {
+        snprintf(response, RESPONSE_SIZE, "error,Invalid query\n");
+        return;
+    }
+    const char* problem;
+    CachedWorkload* entry = acquire_workload(server, path, &problem);
+    if (entry == NULL) {
+        snprintf(response, RESPONSE_SIZE, "error,%.200s\n", problem);
+        return;
+    }
+    if (entry->malformed < 0) {
+        release_workload(server, entry);
+        snprintf(response, RESPONSE_SIZE, "error,Damaged columnar workload %.180s\n", path);
+        return;
+    }
+
+    // Results only depend on the contents and the policy
+    bool found = false;
+    RunSummary summary;
+    pthread_mutex_lock(&server->lock);
+    for (int r = 0; r < entry->num_results; r++) {
+        if (entry->results[r].policy == policy && entry->results[r].quantum == quantum) {
+            summary = entry->results[r].summary;
+            found = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&server->lock);
+
+    if (!found) {
+        if (!worker->loaded || worker->loaded_hash != entry->hash || worker->loaded_size != entry->size) {
+            simulator_copy_workload(worker->sim, entry->workload);
+            worker->loaded_hash = entry->hash;
+            worker->loaded_size = entry->size;
+            worker->loaded = true;
+        }
+        problem = simulator_check_policy(worker->sim, policy);
+        if (problem != NULL) {
+            release_workload(server, entry);
+            snprintf(response, RESPONSE_SIZE, "error,%.200s\n", problem);
+            return;
+        }
+        run_simulation(worker->sim, policy, quantum);
+        summarize_run(worker->sim, &summary);
+
+        pthread_mutex_lock(&server->lock);
+        if (entry->num_results == entry->result_capacity) {
+            int capacity = entry->result_capacity > 0 ? entry->result_capacity * 2 : 4;
+            CachedResult* results = realloc(entry->results, (size_t)capacity * sizeof(CachedResult));
+            if (!results) {
+                printf("Error: Out of memory\n");
+                exit(1);
+            }
+            entry->results = results;
+            entry->result_capacity = capacity;
+        }
+        entry->results[entry->num_results].policy = policy;
+        entry->results[entry->num_results].quantum = quantum;
+        entry->results[entry->num_results].summary = summary;
+        entry->num_results++;
+        pthread_mutex_unlock(&server->lock);
+    }
+
+    snprintf(response, RESPONSE_SIZE, "ok,%.3f,%.3f,%lld,%d\n",
+             summary.average_wait_time, summary.average_turnaround_time, (long long)summary.makespan, entry->malformed);
+    release_workload(server, entry);
+}
+
+/**
+ * Parses a request line
+ * Format: f, s, m, c or r<quantum>, then whitespace and the path of an input file
+ * @param line Request without its newline; trailing whitespace is cut off
+ * @param policy Receives the scheduling policy
+ * @param quantum Receives the time quantum for Round Robin, 0 otherwise
+ * @param path Receives the path, which points into line
+ * @return false if the request is malformed
+ */
+static bool parse_query(char* line, Policy* policy, int* quantum, const char** path) {
+    size_t length = strlen(line);
+    while (length > 0 && (line[length - 1] == '\r' || line[length - 1] == ' ' || line[length - 1] == '\t')) {
+        line[--length] = '\0';
+    }
+
+    char* c = line + 1;
+    *quantum = 0;
+    switch (line[0]) {
+    case 'f':
+        *policy = POLICY_FCFS;
+        break;
+    case 's':
+        *policy = POLICY_SJF;
+        break;
+    case 'm':
+        *policy = POLICY_MLFQ;
+        break;
+    case 'c':
+        *policy = POLICY_CFS;
+        break;
+    case 'r': {
+        char* end;
+        long value = strtol(c, &end, 10);
+        if (end == c || value <= 0 || value > INT_MAX) {
+            return false;
+        }
+        *policy = POLICY_RR;
+        *quantum = (int)value;
+        c = end;
+        break;
+    }
+    default:
+        return false;
+    }
+
+    if (*c != ' ' && *c != '\t') {
+        return false;
+    }
+    while (*c == ' ' || *c == '\t') {
+        c++;
+    }
+    *path = c;
+    return *c != '\0';
+}
+
+/**
+ * Finds the cached workload of a file, reading and parsing it on a miss
+ * A file with the same identity as when it was last read is taken from the
+ * cache without reading it; otherwise its contents are hashed, and only
+ * contents not cached yet are parsed. Concurrent queries for contents being
+ * parsed wait for the first one to finish
+ * @param path Path of the input file
+ * @param problem Set to a description of the problem when NULL is returned
+ * @return The entry, to be handed back with release_workload(), or NULL if the file cannot be read
+ */
+static CachedWorkload* acquire_workload(Server* server, const char* path, const char** problem) {
+    static __thread char message[RESPONSE_SIZE];
+    FileIdentity identity;
+    struct stat st;
+    if (stat(path, &st) == 0) {
+        identity.device = st.st_dev;
+        identity.inode = st.st_ino;
+        identity.size = st.st_size;
+        identity.modified = st.st_mtim;
+        identity.changed = st.st_ctim;
+
+        pthread_mutex_lock(&server->lock);
+        for (int i = 0; i < server->cache_count; i++) {
+            CachedWorkload* entry = server->cache[i];
+            if (entry->workload != NULL && same_identity(&entry->identity, &identity)) {
+                entry->users++;
+                entry->last_used = ++server->uses;
+                pthread_mutex_unlock(&server->lock);
+                return entry;
+            }
+        }
+        pthread_mutex_unlock(&server->lock);
+    }
+
+    size_t size;
+    char* data = read_whole_file(path, &size, &identity);
+    if (data == NULL) {
+        snprintf(message, sizeof(message), "Could not read %.180s", path);
+        *problem = message;
+        return NULL;
+    }
+    uint64_t hash = hash_contents(data, size);
+
+    pthread_mutex_lock(&server->lock);
+    for (;;) {
+        CachedWorkload* entry = NULL;
+        for (int i = 0; i < server->cache_count; i++) {
+            if (server->cache[i]->hash == hash && server->cache[i]->size == size) {
+                entry = server->cache[i];
+                break;
+            }
+        }
+        if (entry == NULL) {
+            break;
+        }
+        if (entry->workload == NULL) {
+            pthread_cond_wait(&server->parsed, &server->lock);
+            continue;
+        }
+        entry->identity = identity;
+        entry->users++;
+        entry->last_used = ++server->uses;
+        pthread_mutex_unlock(&server->lock);
+        free(data);
+        return entry;
+    }
+
+    // Claim the entry before parsing, so other queries wait instead of parsing too
+    CachedWorkload* entry = add_cache_entry(server);
+    entry->hash = hash;
+    entry->size = size;
+    entry->identity = identity;
+    entry->users = 1;
+    entry->last_used = ++server->uses;
+    pthread_mutex_unlock(&server->lock);
+
+    Simulator* workload = simulator_create(&server->options);
+    int malformed = read_input_data(workload, data, size);
+    free(data);
+
+    pthread_mutex_lock(&server->lock);
+    entry->workload = workload;
+    entry->malformed = malformed;
+    pthread_cond_broadcast(&server->parsed);
+    pthread_mutex_unlock(&server->lock);
+    return entry;
+}
+
+/**
+ * Hands back a workload taken with acquire_workload()
+ * @param entry Cached workload
+ */
+static void release_workload(Server* server, CachedWorkload* entry) {
+    pthread_mutex_lock(&server->lock);
+    entry->users--;
+    pthread_mutex_unlock(&server->lock);
+}
+
+/**
+ * Adds an empty entry to the cache, first evicting the least recently used
+ * workload if the cache is full; when every cached workload is in use, the
+ * cache grows past its size until one is released
+ * Called with the server lock held
+ * @return The new entry, with no workload yet
+ */
+static CachedWorkload* add_cache_entry(Server* server) {
+    if (server->cache_count >= server->cache_size) {
+        int victim = -1;
+        for (int i = 0; i < server->cache_count; i++) {
+            const CachedWorkload* entry = server->cache[i];
+            if (entry->users == 0 && entry->workload != NULL &&
+                (victim < 0 || entry->last_used < server->cache[victim]->last_used)) {
+                victim = i;
+            }
+        }
+        if (victim >= 0) {
+            CachedWorkload* evicted = server->cache[victim];
+            simulator_destroy(evicted->workload);
+            free(evicted->results);
+            free(evicted);
+            server->cache[victim] = server->cache[--server->cache_count];
+        } else {
+            CachedWorkload** cache = realloc(server->cache, (size_t)(server->cache_count + 1) * sizeof(CachedWorkload*));
+            if (!cache) {
+                printf("Error: Out of memory\n");
+                exit(1);
+            }
+            server->cache = cache;
+        }
+    }
+
+    CachedWorkload* entry = calloc(1, sizeof(CachedWorkload));
+    if (!entry) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    server->cache[server->cache_count++] = entry;
+    return entry;
+}
+
+/**
+ * Checks whether two identities describe the same unchanged file
+ * @param a First identity
+ * @param b Second identity
+ * @return true if the device, inode, size and timestamps all match
+ */
+static bool same_identity(const FileIdentity* a, const FileIdentity* b) {
+    return a->device == b->device && a->inode == b->inode && a->size == b->size &&
+           a->modified.tv_sec == b->modified.tv_sec && a->modified.tv_nsec == b->modified.tv_nsec &&
+           a->changed.tv_sec == b->changed.tv_sec && a->changed.tv_nsec == b->changed.tv_nsec;
+}
+
+/**
+ * Reads a file into memory
+ * @param path Path of the file
+ * @param size Receives the number of bytes read
+ * @param identity Receives the identity of the file as it was opened
+ * @return The contents, to be freed by the caller, or NULL if the file cannot be read
+ */
+static char* read_whole_file(const char* path, size_t* size, FileIdentity* identity) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return NULL;
+    }
+    identity->device = st.st_dev;
+    identity->inode = st.st_ino;
+    identity->size = st.st_size;
+    identity->modified = st.st_mtim;
+    identity->changed = st.st_ctim;
+
+    size_t capacity = (size_t)st.st_size;
+    char* data = malloc(capacity > 0 ? capacity : 1);
+    if (!data) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    size_t length = 0;
+    while (length < capacity) {
+        ssize_t got = read(fd, data + length, capacity - length);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            break;
+        }
+        length += (size_t)got;
+    }
+    close(fd);
+    if (length < capacity) {
+        free(data);
+        return NULL;
+    }
+    *size = length;
+    return data;
+}
+
+/**
+ * Hashes file contents with 64-bit FNV-1a
+ * @param data Contents
+ * @param size Number of bytes
+ * @return The hash
+ */
+static uint64_t hash_contents(const char* data, size_t size) {
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= UINT64_C(0x100000001b3);
+    }
+    return hash;
+}
+
+/**
+ * Registers an accepted connection in a free slot
+ * Called with the server lock held
+ * @param fd Socket of the connection
+ * @return Index of the slot
+ */
+static int add_connection(Server* server, int fd) {
+    int c = 0;
+    while (c < server->num_connections && server->connections[c].fd >= 0) {
+        c++;
+    }
+    if (c == server->num_connections) {
+        Connection* connections = realloc(server->connections, (size_t)(c + 1) * sizeof(Connection));
+        if (!connections) {
+            printf("Error: Out of memory\n");
+            exit(1);
+        }
+        server->connections = connections;
+        server->num_connections++;
+    }
+    server->connections[c].fd = fd;
+    server->connections[c].length = 0;
+    server->connections[c].busy = false;
+    server->connections[c].closing = false;
+    return c;
+}
+
+/**
+ * Closes a connection, or marks it to be closed once its query is answered
+ * Called with the server lock held
+ * @param c Index of the connection
+ */
+static void close_connection(Server* server, int c) {
+    Connection* connection = &server->connections[c];
+    if (connection->busy) {
+        connection->closing = true;
+        return;
+    }
+    close(connection->fd);
+    connection->fd = -1;
+}
+
+/**
+ * Queues the first complete request line a connection has sent, if any
+ * A line too long for the buffer is answered with an error and the
+ * connection closed. Called with the server lock held
+ * @param c Index of an idle connection
+ */
+static void queue_next_query(Server* server, int c) {
+    Connection* connection = &server->connections[c];
+    char* newline = memchr(connection->buffer, '\n', connection->length);
+    if (newline == NULL) {
+        if (connection->length == QUERY_LINE_SIZE) {
+            static const char error[] = "error,Query too long\n";
+            send_all(connection->fd, error, strlen(error));
+            close_connection(server, c);
+        }
+        return;
+    }
+
+    if (server->num_queries == server->query_capacity) {
+        int capacity = server->query_capacity > 0 ? server->query_capacity * 2 : 16;
+        Query* queries = malloc((size_t)capacity * sizeof(Query));
+        if (!queries) {
+            printf("Error: Out of memory\n");
+            exit(1);
+        }
+        for (int i = 0; i < server->num_queries; i++) {
+            queries[i] = server->queries[(server->query_head + i) % server->query_capacity];
+        }
+        free(server->queries);
+        server->queries = queries;
+        server->query_head = 0;
+        server->query_capacity = capacity;
+    }
+    Query* query = &server->queries[(server->query_head + server->num_queries) % server->query_capacity];
+    size_t length = (size_t)(newline - connection->buffer);
+    memcpy(query->line, connection->buffer, length);
+    query->line[length] = '\0';
+    query->connection = c;
+    query->fd = connection->fd;
+    server->num_queries++;
+
+    connection->length -= length + 1;
+    memmove(connection->buffer, newline + 1, connection->length);
+    connection->busy = true;
+    pthread_cond_signal(&server->work);
+}
+
+/**
+ * Writes a whole response to a socket
+ * @param fd Socket to write to
+ * @param data Bytes to write
+ * @param length Number of bytes
+ * @return false if the client has gone away
+ */
+static bool send_all(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        length -= (size_t)sent;
+    }
+    return true;
+}
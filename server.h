@@ -0,0 +1,8 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "scheduler.h"
+
+int run_server(const char* socket_path, const SimulatorOptions* options, int num_threads, int cache_size);
+
+#endif